@@ -0,0 +1,68 @@
+#include "hal.h"
+#include "adc.h"
+#include "events.h"
+#include "sched.h"
+
+static volatile uint16_t value = 0;
+
+// Running sum of the conversions towards the next result
+static uint16_t sum;
+static uint8_t count;
+
+static uint8_t running = 0;
+static uint16_t last_sample;
+
+void adc_init (void) {
+	// Channel 0, AREF, interrupt on completion, 64 prescale (125kHz, ~104us
+	// per conversion).  The ADC itself is only enabled while sampling.
+	hal_adc_init();
+}
+
+void adc_start (void) {
+	sum = count = 0;
+	hal_adc_enable();
+
+	running = 1;
+	last_sample = sched_now() - SCHED_MS(ADC_SAMPLE_MS);
+}
+
+void adc_stop (void) {
+	running = 0;
+	hal_adc_disable();
+}
+
+uint8_t adc_due (void) {
+	if (!running || hal_adc_busy())
+		return 0;
+
+	return (uint16_t) (sched_now() - last_sample) >= SCHED_MS(ADC_SAMPLE_MS);
+}
+
+void adc_sample (void) {
+	last_sample = sched_now();
+
+	// Going to sleep in this mode starts the conversion, and its interrupt
+	// wakes us.  Any other interrupt can wake us early, the conversion
+	// carries on and ADC_vect picks it up.
+	hal_irq_disable();
+	hal_sleep(HAL_SLEEP_ADC);
+}
+
+uint16_t adc_value (void) {
+	uint16_t v;
+
+	HAL_ATOMIC {
+		v = value;
+	}
+	return v;
+}
+
+HAL_ISR(ADC) {
+	sum += hal_adc_result();
+
+	if (++count == ADC_OVERSAMPLE) {
+		value = sum >> ADC_EXTRA_BITS;
+		event_post(EV_ADC, value);
+		sum = count = 0;
+	}
+}
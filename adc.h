@@ -0,0 +1,44 @@
+#ifndef ADC_H
+#define ADC_H
+
+#include <stdint.h>
+
+/*
+   Light sensor ADC
+
+   Conversions are taken in ADC noise reduction sleep, which stops the CPU and
+   I/O clocks while the ADC runs, and collected by ADC_vect.  Every
+   ADC_OVERSAMPLE conversions are summed and decimated into one result with
+   ADC_EXTRA_BITS more resolution than the ADC has, 12 bits in all.  The sensor
+   noise is enough to dither the extra bits.  Each result is posted as an
+   EV_ADC event and kept for adc_value().
+
+   The main loop calls adc_sample() instead of sched_idle() whenever adc_due()
+   says a conversion is wanted.  Timer1 stops during the conversion, so each
+   one loses about 104us of scheduler time; at one conversion every
+   ADC_SAMPLE_MS that's under 3% slow, and only in sense mode.
+*/
+
+#define ADC_EXTRA_BITS 2
+#define ADC_OVERSAMPLE (1 << (2*ADC_EXTRA_BITS))
+#define ADC_BITS       (10 + ADC_EXTRA_BITS)
+
+// One conversion this often, so a result every ADC_OVERSAMPLE times that
+#define ADC_SAMPLE_MS 4
+
+void adc_init(void);
+
+// Start and stop sampling, the ADC is off while stopped
+void adc_start(void);
+void adc_stop(void);
+
+// A conversion is wanted now
+uint8_t adc_due(void);
+
+// Take one conversion in noise reduction sleep
+void adc_sample(void);
+
+// The latest decimated result, 0 until the first one is in
+uint16_t adc_value(void);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+   Cycle markers for the simulator benchmark
+
+   Built with `make BENCH=1`, BENCH_BEGIN(id) and BENCH_END(id) write id to
+   GPIOR0, a general purpose register nothing else uses.  tools/avrbench
+   runs main.elf under simavr, watches the register and charges the cycles
+   from each begin to its end to id.  A marker is an ldi and an out, two
+   cycles.  Interrupts that land between a begin and its end are counted in,
+   mostly the 1kHz Timer1 tick.
+
+   Bit 7 tells an end from a begin.  BENCH_MARK(BENCH_SCENE(n)) is a single
+   mark when scene n starts, BENCH_MARK(BENCH_DIMMER(n)) when the master
+   dimmer moves to dimmer_levels[n], and BENCH_MARK(BENCH_EVENT(type)) when
+   the main loop takes an input event off the queue (tools/avrlatency).
+
+   Without BENCH, and in the host build, the markers are nothing at all.
+*/
+
+#ifndef BENCH
+#define BENCH 0
+#endif
+
+#define BENCH_END_FLAG 0x80
+
+#define BENCH_FRAME     0x01		// Drawing, output and fade step of a frame
+#define BENCH_WRITE     0x02		// write_data(), fade mix and tlc_commit()
+#define BENCH_HSV2RGB   0x03
+#define BENCH_STEP(n)   (0x10 + (n))	// A program's step(), by programs[] index
+#define BENCH_DIMMER(n) (0x20 + (n))	// dimmer_levels[] step
+#define BENCH_SCENE(n)  (0x40 + (n))
+#define BENCH_EVENT(t)  (0x60 + (t))	// EV_* type
+
+#define BENCH_STEPS 16
+#define BENCH_DIMMERS 16
+#define BENCH_SCENES 32
+
+#if BENCH && !defined(HAL_HOST)
+#include "hal.h"
+#define BENCH_BEGIN(id) hal_bench_mark(id)
+#define BENCH_END(id)   hal_bench_mark((id) | BENCH_END_FLAG)
+#define BENCH_MARK(id)  hal_bench_mark(id)
+#else
+#define BENCH_BEGIN(id)
+#define BENCH_END(id)
+#define BENCH_MARK(id)
+#endif
+
+#endif
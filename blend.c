@@ -0,0 +1,45 @@
+#include "blend.h"
+
+static uint16_t blend (uint16_t d, uint16_t s, uint8_t mode, uint16_t alpha) {
+	switch (mode) {
+	case BLEND_ADD :
+		return blend_add(d, s);
+	case BLEND_MULTIPLY :
+		return blend_multiply(d, s);
+	case BLEND_ALPHA :
+		return blend_alpha(d, s, alpha);
+	}
+	return s;
+}
+
+void blend_leds (tlc_frame_t *dst, const tlc_frame_t *src, uint8_t mask, uint8_t mode, uint16_t alpha) {
+	uint8_t ch = 0;
+
+	for (uint8_t led = 0; led < TLC_CHANNELS/3; led++, mask >>= 1) {
+		if (!(mask & 1)) {
+			ch += 3;
+			continue;
+		}
+
+		for (uint8_t end = ch + 3; ch < end; ch++)
+			tlc_set(dst, ch, blend(tlc_get(dst, ch), tlc_get(src, ch), mode, alpha));
+	}
+}
+
+void blend_palette (tlc_frame_t *dst, const palette_frame_t *src, uint8_t mask, uint8_t mode, uint16_t alpha) {
+	const uint16_t *rgb;
+	uint8_t ch;
+
+	for (uint8_t led = 0; led < PALETTE_LEDS; led++, mask >>= 1) {
+		if (!(mask & 1))
+			continue;
+
+		rgb = src->rgb[src->index[led]];
+		ch = led * 3;
+
+		// Channels go Blue, Red, Green
+		tlc_set(dst, ch,   blend(tlc_get(dst, ch),   rgb[2], mode, alpha));
+		tlc_set(dst, ch+1, blend(tlc_get(dst, ch+1), rgb[0], mode, alpha));
+		tlc_set(dst, ch+2, blend(tlc_get(dst, ch+2), rgb[1], mode, alpha));
+	}
+}
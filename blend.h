@@ -0,0 +1,52 @@
+#ifndef BLEND_H
+#define BLEND_H
+
+#include <stdint.h>
+
+#include "tlc5947.h"
+#include "palette.h"
+
+/*
+   12 bit blend kernels for the compositor
+
+   Each kernel combines a channel already in the destination frame (d) with
+   the same channel of a layer (s), both 0 - BLEND_MAX:
+
+   BLEND_REPLACE  - s
+   BLEND_ADD      - d + s, saturating at BLEND_MAX
+   BLEND_MULTIPLY - d * s / BLEND_MAX, so a full layer leaves d alone
+   BLEND_ALPHA    - d + (s - d)*alpha, alpha out of BLEND_ONE
+
+   blend_leds() applies one of them to the LEDs set in an 8 bit mask, bit n
+   being LED n (channels 3n to 3n+2), and leaves the rest of the destination
+   as it was.  blend_palette() does the same from a palette frame, looking
+   each LED's color up as it goes.  Integer only, the multiplies are 16x16.
+*/
+
+#define BLEND_REPLACE  0
+#define BLEND_ADD      1
+#define BLEND_MULTIPLY 2
+#define BLEND_ALPHA    3
+
+#define BLEND_MAX 0x0FFF
+#define BLEND_ONE 0x1000
+
+static inline uint16_t blend_add (uint16_t d, uint16_t s) {
+	d += s;
+	return d > BLEND_MAX ? BLEND_MAX : d;
+}
+
+static inline uint16_t blend_multiply (uint16_t d, uint16_t s) {
+	// s+1 makes BLEND_MAX exactly one
+	return ((uint32_t) d * (s + 1)) >> 12;
+}
+
+static inline uint16_t blend_alpha (uint16_t d, uint16_t s, uint16_t alpha) {
+	// Made signed before widening, int is only 16 bits on the AVR
+	return d + (int16_t) (((int32_t) (int16_t) (s - d) * alpha + BLEND_ONE/2) >> 12);
+}
+
+void blend_leds(tlc_frame_t *dst, const tlc_frame_t *src, uint8_t mask, uint8_t mode, uint16_t alpha);
+void blend_palette(tlc_frame_t *dst, const palette_frame_t *src, uint8_t mask, uint8_t mode, uint16_t alpha);
+
+#endif
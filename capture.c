@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "capture.h"
+
+#define HEADER_BYTES 16
+#define RECORD_BYTES (4 + TLC_FRAME_BYTES)
+
+static const char magic[4] = {'T', 'L', 'C', 'F'};
+
+static void put32 (uint8_t *p, uint32_t v) {
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static uint32_t get32 (const uint8_t *p) {
+	return p[0] | (p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static int write_header (capture_t *c) {
+	uint8_t h[HEADER_BYTES];
+
+	memcpy(h, magic, 4);
+	h[4] = CAPTURE_VERSION;
+	h[5] = TLC_CHANNELS;
+	h[6] = 12;
+	h[7] = TLC_FRAME_BYTES;
+	put32(&h[8], c->frames);
+	put32(&h[12], c->period);
+
+	if (fwrite(h, sizeof(h), 1, c->f) != 1) {
+		perror(c->path);
+		return -1;
+	}
+	return 0;
+}
+
+int capture_create (capture_t *c, const char *path, uint32_t period) {
+	memset(c, 0, sizeof(*c));
+	c->path = path;
+	c->period = period;
+	c->writing = 1;
+
+	if (!(c->f = fopen(path, "wb"))) {
+		perror(path);
+		return -1;
+	}
+	return write_header(c);
+}
+
+int capture_write (capture_t *c, uint32_t ms, const tlc_frame_t *frame) {
+	uint8_t r[RECORD_BYTES];
+
+	put32(r, ms);
+	memcpy(&r[4], frame->b, TLC_FRAME_BYTES);
+
+	if (fwrite(r, sizeof(r), 1, c->f) != 1) {
+		perror(c->path);
+		return -1;
+	}
+	c->frames++;
+	return 0;
+}
+
+int capture_open (capture_t *c, const char *path) {
+	uint8_t h[HEADER_BYTES];
+
+	memset(c, 0, sizeof(*c));
+	c->path = path;
+
+	if (!(c->f = fopen(path, "rb"))) {
+		perror(path);
+		return -1;
+	}
+
+	if (fread(h, sizeof(h), 1, c->f) != 1 || memcmp(h, magic, 4)) {
+		fprintf(stderr, "%s: not a frame capture\n", path);
+		goto fail;
+	}
+	if (h[4] != CAPTURE_VERSION || h[5] != TLC_CHANNELS || h[6] != 12 || h[7] != TLC_FRAME_BYTES) {
+		fprintf(stderr, "%s: version %u capture of %u x %u bit channels, can't read it\n",
+			path, h[4], h[5], h[6]);
+		goto fail;
+	}
+
+	c->frames = get32(&h[8]);
+	c->period = get32(&h[12]);
+	return 0;
+
+fail :
+	fclose(c->f);
+	c->f = NULL;
+	return -1;
+}
+
+int capture_read (capture_t *c, uint32_t *ms, tlc_frame_t *frame) {
+	uint8_t r[RECORD_BYTES];
+
+	if (c->pos == c->frames)
+		return 0;
+
+	if (fread(r, sizeof(r), 1, c->f) != 1) {
+		fprintf(stderr, "%s: capture cut short\n", c->path);
+		return -1;
+	}
+
+	*ms = get32(r);
+	memcpy(frame->b, &r[4], TLC_FRAME_BYTES);
+	c->pos++;
+	return 1;
+}
+
+int capture_close (capture_t *c) {
+	int ret = 0;
+
+	if (!c->f)
+		return 0;
+
+	// The frame count wasn't known when the header went out
+	if (c->writing && (fseek(c->f, 0, SEEK_SET) || write_header(c)))
+		ret = -1;
+	if (fclose(c->f)) {
+		perror(c->path);
+		ret = -1;
+	}
+	c->f = NULL;
+	return ret;
+}
@@ -0,0 +1,58 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "tlc5947.h"
+
+/*
+   Frame capture files, host side only
+
+   A capture is every frame the TLC5947 latched, with when it latched, so a
+   run can be kept and compared with a later one.  `main-host -c file`
+   writes one and the golden frame test in tests/golden reads them.
+
+   All values are little endian.  A 16 byte header
+
+     char     magic[4]      "TLCF"
+     uint8_t  version       CAPTURE_VERSION
+     uint8_t  channels      24
+     uint8_t  bits          12 per channel
+     uint8_t  frame_bytes   36
+     uint32_t frames        how many records follow
+     uint32_t period        frame period in ms, 0 if it varies
+
+   then a 40 byte record per frame
+
+     uint32_t ms            simulated time of the latch
+     uint8_t  b[36]         the channels packed as in tlc_frame_t, which is
+                            the order they went out on the wire
+
+   frames is filled in when the capture is closed.
+*/
+
+#define CAPTURE_VERSION 1
+
+typedef struct {
+	FILE *f;
+	const char *path;
+	uint32_t frames;	// Written so far, or in the file when reading
+	uint32_t pos;		// Frames read
+	uint32_t period;
+	uint8_t writing;
+} capture_t;
+
+// These all return 0, or -1 after printing what went wrong
+
+int capture_create(capture_t *c, const char *path, uint32_t period);
+int capture_write(capture_t *c, uint32_t ms, const tlc_frame_t *frame);
+
+int capture_open(capture_t *c, const char *path);
+// 1 with the next frame, 0 at the end, -1 on a short or unreadable file
+int capture_read(capture_t *c, uint32_t *ms, tlc_frame_t *frame);
+
+// Finishes the header when writing
+int capture_close(capture_t *c);
+
+#endif
@@ -0,0 +1,36 @@
+#include "color.h"
+#include "bench.h"
+
+// a*b/0xFFF, rounded down, for 12 bit a and b.  Dividing by 4096 and adding
+// back 1/4096th gives the same answer as the division for every 12 bit pair
+// without a 32 bit divide.
+static inline uint16_t scale12 (uint16_t a, uint16_t b) {
+	uint32_t x = (uint32_t) a * b;
+
+	return (x + (x >> 12) + 1) >> 12;
+}
+
+void hsv2rgb (uint16_t h, uint16_t s, uint16_t v, uint16_t *r, uint16_t *g, uint16_t *b) {
+	BENCH_BEGIN(BENCH_HSV2RGB);
+
+	// Sector 0-5 ends up in the top bits, the 12 bit position within the
+	// sector in the bits below it
+	uint32_t h6 = (uint32_t) h * 6;
+	uint8_t  i  = h6 >> 16;
+	uint16_t f  = (uint16_t) h6 >> 4;
+
+	uint16_t p = scale12(v, HSV_MAX - s);
+	uint16_t q = scale12(v, HSV_MAX - scale12(f, s));
+	uint16_t t = scale12(v, HSV_MAX - scale12(HSV_MAX - f, s));
+
+	switch (i) {
+		case 0: *r = v; *g = t; *b = p; break;
+		case 1: *r = q; *g = v; *b = p; break;
+		case 2: *r = p; *g = v; *b = t; break;
+		case 3: *r = p; *g = q; *b = v; break;
+		case 4: *r = t; *g = p; *b = v; break;
+		default: *r = v; *g = p; *b = q; break;
+	}
+
+	BENCH_END(BENCH_HSV2RGB);
+}
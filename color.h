@@ -0,0 +1,23 @@
+#ifndef COLOR_H
+#define COLOR_H
+
+#include <stdint.h>
+
+/*
+   Fixed point HSV
+
+   Hue is a full turn of the color wheel in 16 bits, so it wraps for free
+   (0x0000 = red, 0x5555 = green, 0xAAAA = blue).  Saturation, value and the
+   returned red, green and blue are 12 bit, 0x000 - 0xFFF, the same as a
+   TLC5947 channel.
+*/
+
+#define HUE_TURN 0x10000UL
+#define HSV_MAX  0x0FFF
+
+// Convert a hue in degrees to the 16 bit hue
+#define HUE_DEG(d) ((uint16_t) ((d) * HUE_TURN / 360))
+
+void hsv2rgb (uint16_t h, uint16_t s, uint16_t v, uint16_t *r, uint16_t *g, uint16_t *b);
+
+#endif
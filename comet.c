@@ -0,0 +1,62 @@
+#include <string.h>
+
+#include "comet.h"
+#include "color.h"
+
+void comet_init (comet_t *c, const comet_path_t *path) {
+	comet_path_t p;
+
+	memcpy_P(&p, path, sizeof(p));
+	memset(c, 0, sizeof(*c));
+
+	for (uint8_t n = 0; n < p.comets; n++)
+		c->head[n] = (p.start + n * p.len / p.comets) % p.len;
+}
+
+void comet_step (comet_t *c, const comet_path_t *path, uint16_t target) {
+	comet_path_t p;
+	uint8_t n, i, d, behind;
+	uint16_t level;
+
+	memcpy_P(&p, path, sizeof(p));
+
+	// Heads that got there move on, the new head rises from whatever it was
+	for (n = 0; n < p.comets; n++) {
+		if (c->level[c->head[n]] >= target)
+			c->head[n] = (c->head[n] + 1) % p.len;
+	}
+
+	for (i = 0; i < p.len; i++) {
+		// How far behind the nearest head this LED is, 0 for a head
+		behind = p.len;
+		for (n = 0; n < p.comets; n++) {
+			d = (c->head[n] + p.len - i) % p.len;
+			if (d < behind)
+				behind = d;
+		}
+
+		level = c->level[i];
+		if (behind == 0) {
+			level += p.rise;
+			if (level > target)
+				level = target;
+		} else if (behind <= p.tail) {
+			level = level > p.decay ? level - p.decay : 0;
+		} else {
+			level = 0;
+		}
+		c->level[i] = level;
+	}
+}
+
+void comet_draw (const comet_t *c, const comet_path_t *path, uint16_t hue, tlc_frame_t *f) {
+	comet_path_t p;
+	uint16_t r, g, b;
+
+	memcpy_P(&p, path, sizeof(p));
+
+	for (uint8_t i = 0; i < p.len; i++) {
+		hsv2rgb(hue + p.hue_offset, p.sat, c->level[i], &r, &g, &b);
+		tlc_set_rgb(f, pgm_read_byte(&p.leds[i]), r, g, b);
+	}
+}
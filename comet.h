@@ -0,0 +1,55 @@
+#ifndef COMET_H
+#define COMET_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "tlc5947.h"
+
+/*
+   Comet engine
+
+   A path is a loop of LEDs, given as a flash table of channel offsets like
+   the other LED tables.  One or more comets go round it, evenly spaced.
+   Each comet's head brightens by rise per frame until it reaches the
+   target level passed to comet_step(), then the head moves on to the next
+   LED along.  The LEDs behind a head fade by decay per frame, and anything
+   more than tail LEDs behind the nearest head is off.
+
+   Everything is integer: levels are 12 bit like a TLC5947 channel, hue is
+   the 16 bit hue of color.h.  Paths live in flash and are only read, the
+   per-path state is a comet_t, so a program keeps one of those for each
+   path in its arena.
+*/
+
+// Longest path, and most comets on one path
+#define COMET_MAX_LEDS 8
+#define COMET_MAX      4
+
+typedef struct {
+	const uint8_t *leds;	// Channel offsets, in flash
+	uint8_t len;		// LEDs in the loop, up to COMET_MAX_LEDS
+	uint8_t comets;		// Comets on it, up to COMET_MAX
+	uint8_t start;		// Where the first comet's head starts
+	uint8_t tail;		// Lit LEDs behind each head
+	uint8_t rise;		// Head level per frame
+	uint8_t decay;		// Tail level per frame
+	uint16_t sat;		// 12 bit saturation
+	uint16_t hue_offset;	// Added to the hue passed to comet_draw()
+} comet_path_t;
+
+typedef struct {
+	uint8_t head[COMET_MAX];
+	uint16_t level[COMET_MAX_LEDS];
+} comet_t;
+
+// Place the comets on a path, everything dark.  path is in flash.
+void comet_init(comet_t *c, const comet_path_t *path);
+
+// Move the comets on a frame, heads rising towards target
+void comet_step(comet_t *c, const comet_path_t *path, uint16_t target);
+
+// Draw the path's LEDs into f
+void comet_draw(const comet_t *c, const comet_path_t *path, uint16_t hue, tlc_frame_t *f);
+
+#endif
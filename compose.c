@@ -0,0 +1,84 @@
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "compose.h"
+#include "blend.h"
+#include "sched.h"
+#include "bench.h"
+
+compose_stats_t compose_stats[SCENE_LAYERS];
+
+typedef struct {
+	program_t prog;
+	layer_def_t def;
+
+	// Milliseconds since the last step, less the remainder carried over
+	uint16_t elapsed;
+
+	program_state_t state;
+	tlc_frame_t frame;
+} layer_t;
+
+static layer_t layers[SCENE_LAYERS];
+static uint8_t num_layers;
+static uint8_t period;
+static uint8_t init = 0;
+
+uint8_t compose_start (const scene_t *scene) {
+	uint8_t n;
+
+	num_layers = pgm_read_byte(&scene->layers);
+	period = 0xFF;
+
+	for (n = 0; n < num_layers; n++) {
+		memcpy_P(&layers[n].def, &scene->layer[n], sizeof(layer_def_t));
+		program_get(&programs[layers[n].def.program], &layers[n].prog);
+
+		if (layers[n].prog.period < period)
+			period = layers[n].prog.period;
+
+		// Due on the first frame
+		layers[n].elapsed = layers[n].prog.period;
+		compose_stats[n].max_cost = 0;
+	}
+
+	init = 1;
+	return period;
+}
+
+void compose_frame (tlc_frame_t *out) {
+	layer_t *l;
+	uint16_t start;
+
+	memset(out, 0, sizeof(*out));
+
+	for (uint8_t n = 0; n < num_layers; n++) {
+		l = &layers[n];
+		start = sched_clock();
+
+		if (init) {
+			memset(&l->frame, 0, sizeof(l->frame));
+			memset(&l->state, 0, l->prog.state_size);
+			l->prog.init(&l->state, &l->frame);
+		}
+
+		if (l->elapsed >= l->prog.period) {
+			BENCH_BEGIN(BENCH_STEP(l->def.program));
+			l->prog.step(&l->state, &l->frame);
+			BENCH_END(BENCH_STEP(l->def.program));
+			l->elapsed -= l->prog.period;
+		}
+		l->elapsed += period;
+
+		if (l->prog.flags & PROG_PALETTE)
+			blend_palette(out, &l->state.palette, l->def.mask, l->def.mode, l->def.alpha);
+		else
+			blend_leds(out, &l->frame, l->def.mask, l->def.mode, l->def.alpha);
+
+		compose_stats[n].cost = sched_clock() - start;
+		if (compose_stats[n].cost > compose_stats[n].max_cost)
+			compose_stats[n].max_cost = compose_stats[n].cost;
+	}
+
+	init = 0;
+}
@@ -0,0 +1,41 @@
+#ifndef COMPOSE_H
+#define COMPOSE_H
+
+#include <stdint.h>
+
+#include "tlc5947.h"
+#include "programs.h"
+
+/*
+   Layer compositor
+
+   compose_start() loads a scene out of flash.  Every layer gets its own
+   state arena and its own frame, which it keeps between frames as programs
+   only redraw what changes.  The scene runs at the shortest frame period of
+   its layers.  Each layer keeps count of the milliseconds since it last
+   stepped and steps on the first frame that brings it to its own period,
+   so a 50ms layer over a 20ms scene steps 40ms and 60ms apart, 50ms on
+   average.  In between it shows what it last drew.
+
+   compose_frame() steps whichever layers are due and builds the output frame
+   from black, blending the layers on bottom first.  The first frame after
+   compose_start() runs every layer's init() first.
+
+   compose_stats[n].cost is how long layer n took on the last frame, stepping
+   and blending, in Timer1 counts (8us).
+*/
+
+typedef struct {
+	uint16_t cost;		// Timer1 counts the layer took last frame
+	uint16_t max_cost;	// Most it has taken since compose_start()
+} compose_stats_t;
+
+extern compose_stats_t compose_stats[SCENE_LAYERS];
+
+// Load a scene, returns its frame period in milliseconds
+uint8_t compose_start(const scene_t *scene);
+
+// Draw the next frame of the scene into out
+void compose_frame(tlc_frame_t *out);
+
+#endif
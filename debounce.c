@@ -0,0 +1,82 @@
+#include "debounce.h"
+
+#define GESTURE_LONG_SAMPLES   (GESTURE_LONG_MS / DEBOUNCE_SAMPLE_MS)
+#define GESTURE_DOUBLE_SAMPLES (GESTURE_DOUBLE_MS / DEBOUNCE_SAMPLE_MS)
+
+// Recognizer states
+#define G_IDLE 0	// Released, nothing pending
+#define G_DOWN 1	// First press, not long yet
+#define G_UP   2	// Released after a first press, waiting for a second
+#define G_HELD 3	// Already reported, waiting for the release
+
+void debounce_init (debounce_t *d, uint8_t value) {
+	d->stable = d->candidate = value;
+	d->count = 0;
+}
+
+uint8_t debounce (debounce_t *d, uint8_t raw) {
+	if (raw == d->stable) {
+		d->count = 0;
+		return 0;
+	}
+
+	// Bounced to something else, start counting again
+	if (raw != d->candidate) {
+		d->candidate = raw;
+		d->count = 0;
+	}
+
+	if (++d->count < DEBOUNCE_SAMPLES)
+		return 0;
+
+	d->stable = raw;
+	d->count = 0;
+	return 1;
+}
+
+void gesture_init (gesture_t *g, uint8_t pressed) {
+	debounce_init(&g->db, pressed);
+	// Held at power up, wait for it to be let go
+	g->state = pressed ? G_HELD : G_IDLE;
+	g->timer = 0;
+}
+
+uint8_t gesture_sample (gesture_t *g, uint8_t pressed) {
+	uint8_t edge = debounce(&g->db, pressed);
+	pressed = g->db.stable;
+
+	if (edge)
+		g->timer = 0;
+	else if (g->timer < 0xFF)
+		g->timer++;
+
+	switch (g->state) {
+	case G_IDLE :
+		if (edge && pressed)
+			g->state = G_DOWN;
+		break;
+	case G_DOWN :
+		if (edge) {
+			g->state = G_UP;
+		} else if (g->timer >= GESTURE_LONG_SAMPLES) {
+			g->state = G_HELD;
+			return GESTURE_LONG;
+		}
+		break;
+	case G_UP :
+		if (edge) {
+			g->state = G_HELD;
+			return GESTURE_DOUBLE;
+		} else if (g->timer >= GESTURE_DOUBLE_SAMPLES) {
+			g->state = G_IDLE;
+			return GESTURE_SHORT;
+		}
+		break;
+	case G_HELD :
+		if (edge && !pressed)
+			g->state = G_IDLE;
+		break;
+	}
+
+	return GESTURE_NONE;
+}
@@ -0,0 +1,63 @@
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+
+/*
+   Input debounce and button gestures
+
+   Inputs are sampled from a timer every DEBOUNCE_SAMPLE_MS rather than on
+   their pin change interrupts, so bounce only costs a few samples and
+   nothing ever has to wait.  A new value is taken once it has been read
+   DEBOUNCE_SAMPLES times in a row.  This works on whole bytes, so one
+   debounce_t can look after the three slide switch pins together.
+
+   The button goes through a gesture recognizer on top of that:
+
+     short press   pressed and released, and no second press within
+                   GESTURE_DOUBLE_MS of letting go
+     double press  a second press within GESTURE_DOUBLE_MS, reported as
+                   soon as it goes down
+     long press    held for GESTURE_LONG_MS, reported while still held
+
+   A short press can only be told from the first half of a double once the
+   double press window has run out, so it's reported that much late.
+
+   None of this touches the hardware, so it runs the same on the host.
+*/
+
+#define DEBOUNCE_SAMPLE_MS 4
+#define DEBOUNCE_SAMPLES   5
+
+#define GESTURE_LONG_MS    600
+#define GESTURE_DOUBLE_MS  300
+
+#define GESTURE_NONE   0
+#define GESTURE_SHORT  1
+#define GESTURE_LONG   2
+#define GESTURE_DOUBLE 3
+
+typedef struct {
+	uint8_t stable;		// The debounced value
+	uint8_t candidate;	// What the input has been reading instead
+	uint8_t count;		// For how many samples
+} debounce_t;
+
+typedef struct {
+	debounce_t db;
+	uint8_t state;
+	uint8_t timer;		// Samples since the last debounced edge
+} gesture_t;
+
+// Start off as if value had been stable for ever
+void debounce_init(debounce_t *d, uint8_t value);
+
+// Feed one sample, returns 1 when the debounced value changes
+uint8_t debounce(debounce_t *d, uint8_t raw);
+
+void gesture_init(gesture_t *g, uint8_t pressed);
+
+// Feed one sample of the button, 1 for pressed.  Returns a GESTURE_*.
+uint8_t gesture_sample(gesture_t *g, uint8_t pressed);
+
+#endif
@@ -0,0 +1,20 @@
+#include "events.h"
+
+volatile event_t event_queue[EVENT_QUEUE_LEN];
+volatile uint8_t event_head = 0;
+volatile uint8_t event_tail = 0;
+volatile uint8_t event_overflows = 0;
+
+uint8_t event_get (event_t *ev) {
+	uint8_t tail = event_tail;
+
+	if (tail == event_head)
+		return 0;
+
+	ev->type  = event_queue[tail].type;
+	ev->value = event_queue[tail].value;
+
+	// Hand the slot back only once it has been copied out
+	event_tail = (tail + 1) & (EVENT_QUEUE_LEN - 1);
+	return 1;
+}
@@ -0,0 +1,57 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+
+/*
+   Input events
+
+   The button, slide switch and ADC interrupts post events into a small ring
+   buffer and the main loop takes them out, so each handler is only a few
+   instructions and nothing is lost while main is busy drawing a frame.
+
+   Interrupts don't nest on the AVR, so between them the handlers are a single
+   producer and main is the single consumer.  Only the producer writes
+   event_head and only the consumer writes event_tail, both are one byte, so
+   neither side needs to turn interrupts off.  If the queue is ever full the
+   new event is dropped and counted in event_overflows.
+*/
+
+// Must be a power of two
+#define EVENT_QUEUE_LEN 16
+
+#define EV_BUTTON 1	// value: GESTURE_SHORT, _LONG or _DOUBLE
+#define EV_SWITCH 2	// value: slide switch pins of PIND
+#define EV_ADC    3	// value: conversion result
+
+typedef struct {
+	uint8_t type;
+	uint16_t value;
+} event_t;
+
+extern volatile event_t event_queue[EVENT_QUEUE_LEN];
+extern volatile uint8_t event_head;
+extern volatile uint8_t event_tail;
+extern volatile uint8_t event_overflows;
+
+// Only call this from an interrupt handler
+static inline void event_post (uint8_t type, uint16_t value) {
+	uint8_t head = event_head;
+	uint8_t next = (head + 1) & (EVENT_QUEUE_LEN - 1);
+
+	if (next == event_tail) {
+		event_overflows++;
+		return;
+	}
+
+	event_queue[head].type  = type;
+	event_queue[head].value = value;
+
+	// Publish the slot only once it's filled in
+	event_head = next;
+}
+
+// Take the oldest event, returns 0 if there isn't one
+uint8_t event_get(event_t *ev);
+
+#endif
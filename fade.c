@@ -0,0 +1,75 @@
+#include <string.h>
+
+#include "fade.h"
+#include "sched.h"
+
+fade_stats_t fade_stats;
+
+// The frame we're fading from, and the blend that last went out
+static tlc_frame_t from;
+static tlc_frame_t out;
+
+// How far into the fade we are, 0 - FADE_ONE, and how much each frame adds
+static uint16_t pos;
+static uint16_t step;
+static uint8_t active = 0;
+
+// Set once out holds a blend of the current fade.  A fade started while
+// nothing is being drawn (sense mode in a bright room) never mixes, and
+// out is left with whatever went out before.
+static uint8_t mixed = 0;
+
+void fade_start (const tlc_frame_t *shown, uint8_t frames) {
+	memcpy(&from, active && mixed ? &out : shown, sizeof(from));
+
+	pos = 0;
+	step = FADE_ONE / (frames ? frames : 1);
+	active = 1;
+	mixed = 0;
+	fade_stats.max_cost = 0;
+}
+
+void fade_stop (void) {
+	active = 0;
+}
+
+uint8_t fade_active (void) {
+	return active;
+}
+
+const tlc_frame_t *fade_mix (const tlc_frame_t *to) {
+	uint16_t start;
+	uint16_t a, b;
+
+	if (!active)
+		return to;
+
+	start = sched_clock();
+
+	for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++) {
+		a = tlc_get(&from, ch);
+		b = tlc_get(to, ch);
+
+		// a + (b - a)*pos, rounded.  The difference has to be made signed
+		// before widening, int is only 16 bits here.
+		a += (int16_t) (((int32_t) (int16_t) (b - a) * pos + FADE_ONE/2) >> 12);
+		tlc_set(&out, ch, a);
+	}
+	mixed = 1;
+
+	fade_stats.cost = sched_clock() - start;
+	if (fade_stats.cost > fade_stats.max_cost)
+		fade_stats.max_cost = fade_stats.cost;
+
+	return &out;
+}
+
+void fade_advance (void) {
+	if (!active)
+		return;
+
+	if (pos >= FADE_ONE - step)
+		active = 0;
+	else
+		pos += step;
+}
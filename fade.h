@@ -0,0 +1,49 @@
+#ifndef FADE_H
+#define FADE_H
+
+#include <stdint.h>
+
+#include "tlc5947.h"
+
+/*
+   Crossfade between programs
+
+   fade_start() takes a copy of what is on the LEDs, and from then on every
+   frame that goes out is a blend of that copy and the incoming program's
+   frame, moving over to the new program in equal steps over the given
+   number of frames.  The blend is done per channel in 12 bit fixed point,
+   into a static buffer, so nothing is allocated while fading.
+
+   fade_mix() only blends, fade_advance() moves the fade on a frame, so a
+   frame can be written more than once without speeding the fade up.
+
+   fade_stats.cost is how long the last blend took in Timer1 counts (8us).
+*/
+
+// Blend weights are 12 bit, FADE_ONE is all the new frame
+#define FADE_ONE 0x1000
+
+typedef struct {
+	uint16_t cost;		// Timer1 counts the last fade_mix() took
+	uint16_t max_cost;	// Most it has taken since the last fade_start()
+} fade_stats_t;
+
+extern fade_stats_t fade_stats;
+
+// Start fading from shown to whatever is mixed next, over frames frames.
+// Starting again part way through picks up from the blend that was showing,
+// if one has gone out since the last start.
+void fade_start(const tlc_frame_t *shown, uint8_t frames);
+
+// Drop any fade, frames go out as drawn from now on
+void fade_stop(void);
+
+uint8_t fade_active(void);
+
+// The frame to send out for the incoming frame to
+const tlc_frame_t *fade_mix(const tlc_frame_t *to);
+
+// Move the fade on one frame
+void fade_advance(void);
+
+#endif
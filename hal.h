@@ -0,0 +1,36 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+/*
+   Hardware abstraction
+
+   Everything the firmware does to port D, Timer1, Timer2, the ADC, the pin
+   change wake up and the sleep modes goes through here, so the same code
+   builds for the board and, with HAL_HOST defined, for Linux.
+
+   hal_avr.h is the real thing: static inline wrappers that compile down to
+   the register accesses they replace, so the AVR build costs nothing extra.
+   hal_host.h and hal_host.c simulate just enough of the ATmega168 to run the
+   firmware: the timers tick, scripted button, switch and light sensor
+   changes arrive on time and interrupt handlers run, all on a simulated
+   clock that only moves while the firmware sleeps.  See `make host`.
+
+   Interrupt handlers are written HAL_ISR(TIMER1_COMPA) rather than
+   ISR(TIMER1_COMPA_vect) so the host build can call them.  The USART and
+   SPI output backends stay AVR only.
+*/
+
+// Sleep modes for hal_sleep()
+#define HAL_SLEEP_IDLE       0
+#define HAL_SLEEP_ADC        1
+#define HAL_SLEEP_POWER_DOWN 2
+
+#ifdef HAL_HOST
+#include "hal_host.h"
+#else
+#include "hal_avr.h"
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef HAL_AVR_H
+#define HAL_AVR_H
+
+// Included by hal.h, don't include this directly
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/power.h>
+#include <util/atomic.h>
+
+#define HAL_ISR(vect)       ISR(vect##_vect)
+#define HAL_EMPTY_ISR(vect) EMPTY_INTERRUPT(vect##_vect)
+
+// Run the following block with interrupts off, restoring them after
+#define HAL_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+
+// Port D
+
+static inline void hal_port_output (uint8_t mask) {
+	DDRD |= mask;
+}
+
+static inline void hal_port_write (uint8_t val) {
+	PORTD = val;
+}
+
+static inline void hal_port_set (uint8_t mask) {
+	PORTD |= mask;
+}
+
+static inline void hal_port_clear (uint8_t mask) {
+	PORTD &= ~mask;
+}
+
+static inline uint8_t hal_pins (void) {
+	return PIND;
+}
+
+// Pin change wake up from port D, PCINT[16:23].  Only the pins in the mask
+// interrupt.
+static inline void hal_wake_init (void) {
+	PCICR |= (1 << PCIE2);
+}
+
+static inline void hal_wake_pins (uint8_t mask) {
+	PCMSK2 = mask;
+}
+
+// Timer1, CTC mode, prescale by 64, interrupt on compare A every top+1
+// counts
+
+static inline void hal_timer1_init (uint16_t top) {
+	TCCR1A = 0;
+	TCCR1B = (1 << WGM12) | (1 << CS11) | (1 << CS10);
+	OCR1A  = top;
+	TIMSK1 = (1 << OCIE1A);
+}
+
+static inline uint16_t hal_timer1_count (void) {
+	return TCNT1;
+}
+
+// The compare match has happened but its interrupt hasn't run yet
+static inline uint8_t hal_timer1_pending (void) {
+	return TIFR1 & (1 << OCF1A);
+}
+
+// Timer2, CTC mode, prescale by 256, interrupt on compare A every top+1
+// counts
+static inline void hal_timer2_init (uint8_t top) {
+	TCCR2A = (1 << WGM21);
+	TCCR2B = (1 << CS22) | (1 << CS21);
+	OCR2A  = top;
+	TIMSK2 = (1 << OCIE2A);
+}
+
+// ADC, channel 0 against AREF, prescale by 64, interrupt on completion
+
+static inline void hal_adc_init (void) {
+	ADMUX = 0;
+	ADCSRA = (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1);
+}
+
+static inline void hal_adc_enable (void) {
+	ADCSRA |= (1 << ADEN);
+}
+
+static inline void hal_adc_disable (void) {
+	ADCSRA &= ~(1 << ADEN);
+}
+
+static inline uint8_t hal_adc_busy (void) {
+	return ADCSRA & (1 << ADSC);
+}
+
+static inline uint16_t hal_adc_result (void) {
+	return ADC;
+}
+
+// Clock to the ADC, off while powered down
+static inline void hal_adc_power (uint8_t on) {
+	if (on)
+		power_adc_enable();
+	else
+		power_adc_disable();
+}
+
+// Benchmark markers for the simulator, see bench.h
+
+static inline void hal_bench_mark (uint8_t id) {
+	GPIOR0 = id;
+}
+
+// Interrupts and sleep
+
+static inline void hal_irq_enable (void) {
+	sei();
+}
+
+static inline void hal_irq_disable (void) {
+	cli();
+}
+
+// Sleep until an interrupt.  Call with interrupts off, it returns with them
+// on.  sei() only takes effect after the next instruction, so nothing can
+// run between it and the sleep.  In HAL_SLEEP_ADC going to sleep starts a
+// conversion.
+static inline void hal_sleep (uint8_t mode) {
+	switch (mode) {
+	case HAL_SLEEP_ADC :
+		set_sleep_mode(SLEEP_MODE_ADC);
+		break;
+	case HAL_SLEEP_POWER_DOWN :
+		set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+		break;
+	default :
+		set_sleep_mode(SLEEP_MODE_IDLE);
+		break;
+	}
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
+}
+
+#endif
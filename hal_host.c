@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hal.h"
+#include "tlc5947.h"
+#include "input.h"
+
+/*
+   Host simulation of the ATmega168, for `make host`
+
+   Simulated time only moves while the firmware sleeps, so everything it
+   does between sleeps takes no time at all.  That's fine for seeing what it
+   draws, but it says nothing about how long drawing takes on the chip.
+*/
+
+#define US_PER_COUNT(prescale) ((prescale) * 1000000.0 / F_CPU)
+
+// 13 ADC clocks at F_CPU/64
+#define ADC_CONVERSION_US ((uint32_t) (13 * 64 * 1000000ULL / F_CPU))
+
+HAL_ISR(TIMER1_COMPA);
+HAL_ISR(TIMER2_COMPA);
+HAL_ISR(ADC);
+HAL_ISR(PCINT2);
+
+typedef struct {
+	uint32_t period;	// Microseconds between compare matches
+	uint32_t phase;		// Microseconds since the last one
+	uint8_t on;
+} sim_timer_t;
+
+static uint64_t now_us = 0;
+static uint64_t end_us;
+static sim_timer_t timer1, timer2;
+
+static uint8_t ddr, port, pins;
+static uint8_t wake_mask;
+static uint8_t adc_on;
+static uint16_t light = 100;
+
+// Scripted input changes
+#define SCRIPT_LEN 256
+
+typedef struct {
+	uint32_t ms;
+	uint8_t set, clear;	// Pins to raise and lower
+	int16_t light;		// New sensor level, -1 to leave it
+} script_t;
+
+static script_t script[SCRIPT_LEN];
+static int script_len = 0;
+static int script_pos = 0;
+
+static void (*port_watch)(uint8_t port);
+static int (*at_end)(void);
+
+// For the summary
+static uint32_t latches = 0;
+static uint32_t wakeups = 0;
+static clock_t started;
+
+static void finish (void) {
+	double wall = (double) (clock() - started) / CLOCKS_PER_SEC;
+
+	printf("simulated %.3fs in %.3fs: %u frames latched, %u wakeups\n",
+		now_us / 1e6, wall, latches, wakeups);
+	exit(at_end ? at_end() : EXIT_SUCCESS);
+}
+
+void hal_host_watch_port (void (*watch)(uint8_t port)) {
+	port_watch = watch;
+}
+
+void hal_host_at_end (int (*end)(void)) {
+	at_end = end;
+}
+
+void hal_host_init (uint32_t run_ms) {
+	end_us = (uint64_t) run_ms * 1000;
+	pins = SWITCH_ON_PIN;
+	started = clock();
+}
+
+uint64_t hal_host_now (void) {
+	return now_us;
+}
+
+int hal_host_script (const char *path) {
+	char line[80], what[16];
+	FILE *f = fopen(path, "r");
+	unsigned long ms;
+	int level, n;
+	script_t *s;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+
+	for (n = 1; fgets(line, sizeof(line), f); n++) {
+		char *hash = strchr(line, '#');
+		if (hash)
+			*hash = 0;
+		if (sscanf(line, "%lu %15s", &ms, what) != 2)
+			continue;
+
+		if (script_len == SCRIPT_LEN) {
+			fprintf(stderr, "%s:%d: too many lines\n", path, n);
+			break;
+		}
+
+		s = &script[script_len];
+		s->ms = ms;
+		s->set = s->clear = 0;
+		s->light = -1;
+
+		if (!strcmp(what, "press")) {
+			s->set = BUTTON_PIN;
+		} else if (!strcmp(what, "release")) {
+			s->clear = BUTTON_PIN;
+		} else if (!strcmp(what, "off")) {
+			s->set = SWITCH_OFF_PIN;
+			s->clear = SWITCH_SENSE_PIN | SWITCH_ON_PIN;
+		} else if (!strcmp(what, "sense")) {
+			s->set = SWITCH_SENSE_PIN;
+			s->clear = SWITCH_OFF_PIN | SWITCH_ON_PIN;
+		} else if (!strcmp(what, "on")) {
+			s->set = SWITCH_ON_PIN;
+			s->clear = SWITCH_OFF_PIN | SWITCH_SENSE_PIN;
+		} else if (!strcmp(what, "light") && sscanf(line, "%*u %*s %d", &level) == 1) {
+			s->light = level < 0 ? 0 : level > 1023 ? 1023 : level;
+		} else {
+			fprintf(stderr, "%s:%d: don't know \"%s\"\n", path, n, what);
+			fclose(f);
+			return -1;
+		}
+
+		if (script_len && ms < script[script_len-1].ms) {
+			fprintf(stderr, "%s:%d: out of order\n", path, n);
+			fclose(f);
+			return -1;
+		}
+		script_len++;
+	}
+
+	fclose(f);
+	return 0;
+}
+
+// Apply whatever the script has up to now, returns the pins that changed
+static uint8_t run_script (void) {
+	uint8_t was = pins;
+
+	while (script_pos < script_len && (uint64_t) script[script_pos].ms * 1000 <= now_us) {
+		pins = (pins | script[script_pos].set) & ~script[script_pos].clear;
+		if (script[script_pos].light >= 0)
+			light = script[script_pos].light;
+		script_pos++;
+	}
+
+	return pins ^ was;
+}
+
+static uint64_t next_script (void) {
+	if (script_pos < script_len)
+		return (uint64_t) script[script_pos].ms * 1000;
+	return UINT64_MAX;
+}
+
+static uint32_t timer_left (const sim_timer_t *t) {
+	return t->on ? t->period - t->phase : UINT32_MAX;
+}
+
+static uint8_t timer_run (sim_timer_t *t, uint32_t us) {
+	if (!t->on)
+		return 0;
+
+	t->phase += us;
+	if (t->phase < t->period)
+		return 0;
+
+	t->phase -= t->period;
+	return 1;
+}
+
+// Move the clock on, stopping at the end of the run
+static void advance (uint64_t us) {
+	if (now_us + us >= end_us) {
+		now_us = end_us;
+		finish();
+	}
+	now_us += us;
+}
+
+// Idle: the timers run and the first compare match wakes us
+static void sleep_idle (void) {
+	uint64_t step;
+	uint8_t fired1, fired2;
+
+	do {
+		step = timer_left(&timer1);
+		if (timer_left(&timer2) < step)
+			step = timer_left(&timer2);
+		if (next_script() - now_us < step)
+			step = next_script() - now_us;
+
+		// Nothing will ever wake us
+		if (step == UINT32_MAX) {
+			advance(end_us - now_us);
+			return;
+		}
+
+		advance(step);
+		run_script();
+
+		fired1 = timer_run(&timer1, step);
+		fired2 = timer_run(&timer2, step);
+		if (fired1)
+			hal_isr_TIMER1_COMPA();
+		if (fired2)
+			hal_isr_TIMER2_COMPA();
+	} while (!fired1 && !fired2);
+}
+
+// ADC noise reduction: the timers stop, the conversion wakes us
+static void sleep_adc (void) {
+	advance(ADC_CONVERSION_US);
+	run_script();
+
+	if (adc_on)
+		hal_isr_ADC();
+}
+
+// Power down: everything stops until a watched pin changes
+static void sleep_power_down (void) {
+	while (!(run_script() & wake_mask)) {
+		if (next_script() == UINT64_MAX)
+			finish();
+		advance(next_script() - now_us);
+	}
+
+	hal_isr_PCINT2();
+}
+
+void hal_port_output (uint8_t mask) {
+	ddr |= mask;
+}
+
+static void port_changed (uint8_t val) {
+	if ((val & ~port) & TLC_XLAT)
+		latches++;
+	port = val;
+
+	if (port_watch)
+		port_watch(port);
+}
+
+void hal_port_write (uint8_t val) {
+	port_changed(val);
+}
+
+void hal_port_set (uint8_t mask) {
+	port_changed(port | mask);
+}
+
+void hal_port_clear (uint8_t mask) {
+	port_changed(port & ~mask);
+}
+
+uint8_t hal_pins (void) {
+	// Outputs read back what was written
+	return (pins & ~ddr) | (port & ddr);
+}
+
+void hal_wake_init (void) {
+}
+
+void hal_wake_pins (uint8_t mask) {
+	wake_mask = mask;
+}
+
+void hal_timer1_init (uint16_t top) {
+	timer1.period = (top + 1) * US_PER_COUNT(64);
+	timer1.phase = 0;
+	timer1.on = 1;
+}
+
+uint16_t hal_timer1_count (void) {
+	return timer1.phase / US_PER_COUNT(64);
+}
+
+uint8_t hal_timer1_pending (void) {
+	// Compare matches are handled as soon as they happen
+	return 0;
+}
+
+void hal_timer2_init (uint8_t top) {
+	timer2.period = (top + 1) * US_PER_COUNT(256);
+	timer2.phase = 0;
+	timer2.on = 1;
+}
+
+void hal_adc_init (void) {
+}
+
+void hal_adc_enable (void) {
+	adc_on = 1;
+}
+
+void hal_adc_disable (void) {
+	adc_on = 0;
+}
+
+uint8_t hal_adc_busy (void) {
+	// Conversions finish inside hal_sleep()
+	return 0;
+}
+
+uint16_t hal_adc_result (void) {
+	return light;
+}
+
+void hal_adc_power (uint8_t on) {
+}
+
+void hal_irq_enable (void) {
+}
+
+void hal_irq_disable (void) {
+}
+
+void hal_sleep (uint8_t mode) {
+	wakeups++;
+
+	switch (mode) {
+	case HAL_SLEEP_ADC :
+		sleep_adc();
+		break;
+	case HAL_SLEEP_POWER_DOWN :
+		sleep_power_down();
+		break;
+	default :
+		sleep_idle();
+		break;
+	}
+}
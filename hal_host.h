@@ -0,0 +1,84 @@
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+// Included by hal.h, don't include this directly
+
+#include <stdint.h>
+
+// Port D bit names, as avr/io.h has them
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define PIND4 4
+#define PIND5 5
+#define PIND6 6
+#define PIND7 7
+
+// Handlers are plain functions that hal_host.c calls when their interrupt
+// fires
+#define HAL_ISR(vect)       void hal_isr_##vect(void)
+#define HAL_EMPTY_ISR(vect) void hal_isr_##vect(void) {}
+
+// Nothing interrupts the firmware except while it sleeps, so there's
+// nothing to lock out
+#define HAL_ATOMIC for (uint8_t hal_once = 1; hal_once; hal_once = 0)
+
+void hal_port_output(uint8_t mask);
+void hal_port_write(uint8_t val);
+void hal_port_set(uint8_t mask);
+void hal_port_clear(uint8_t mask);
+uint8_t hal_pins(void);
+
+void hal_wake_init(void);
+void hal_wake_pins(uint8_t mask);
+
+void hal_timer1_init(uint16_t top);
+uint16_t hal_timer1_count(void);
+uint8_t hal_timer1_pending(void);
+void hal_timer2_init(uint8_t top);
+
+void hal_adc_init(void);
+void hal_adc_enable(void);
+void hal_adc_disable(void);
+uint8_t hal_adc_busy(void);
+uint16_t hal_adc_result(void);
+void hal_adc_power(uint8_t on);
+
+void hal_irq_enable(void);
+void hal_irq_disable(void);
+void hal_sleep(uint8_t mode);
+
+/*
+   Host side only
+
+   The simulation stops, printing a summary, once run_ms of simulated time
+   have passed or the firmware powers down with nothing left in the script
+   to wake it.  The script is a text file of "<ms> <what>" lines, in time
+   order, where what is one of
+
+     press, release     the button
+     off, sense, on     the slide switch
+     light <level>      the light sensor, 0 - 1023
+
+   '#' starts a comment.  Without a script the switch is on, the button up
+   and the sensor reads dark.
+*/
+void hal_host_init(uint32_t run_ms);
+int hal_host_script(const char *path);
+
+// Have watch called with port D every time it's written
+void hal_host_watch_port(void (*watch)(uint8_t port));
+
+// Have end called when the run is over.  What it returns is the exit status.
+void hal_host_at_end(int (*end)(void));
+
+// Simulated time since the start, in microseconds
+uint64_t hal_host_now(void);
+
+#endif
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "tlc_model.h"
+#include "capture.h"
+
+/*
+   Entry point of the host build.  main.c is compiled with its main()
+   renamed to firmware_main(), which runs on the simulated hardware in
+   hal_host.c until the run is over.  Everything written to port D goes
+   through the TLC5947 model, and the run fails if the bit stream was ever
+   wrong.  With -c every latched frame is also written to a capture file
+   (capture.h).
+*/
+
+int firmware_main(void);
+
+static tlc_model_t tlc;
+
+static capture_t capture;
+static uint8_t capture_failed = 0;
+
+static void watch_port (uint8_t port) {
+	uint32_t latches = tlc.latches;
+	tlc_frame_t f;
+
+	tlc_model_port(&tlc, port);
+
+	if (capture.f && tlc.latches != latches && !capture_failed) {
+		tlc_model_frame(&tlc, &f);
+		if (capture_write(&capture, hal_host_now() / 1000, &f))
+			capture_failed = 1;
+	}
+}
+
+static int end (void) {
+	tlc_model_report(&tlc);
+
+	if (capture.f) {
+		if (capture_close(&capture))
+			capture_failed = 1;
+		else
+			printf("%u frames captured\n", capture.frames);
+	}
+
+	return tlc_model_errors(&tlc) || capture_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void usage (const char *name) {
+	fprintf(stderr, "usage: %s [-t ms] [-s script] [-c capture]\n"
+		"  -t ms       simulated time to run for (default 10000)\n"
+		"  -s script   button, switch and light sensor changes, see hal_host.h\n"
+		"  -c capture  write every latched frame to this file, see capture.h\n",
+		name);
+	exit(EXIT_FAILURE);
+}
+
+int main (int argc, char **argv) {
+	uint32_t run_ms = 10000;
+	const char *script = NULL;
+	const char *capture_path = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:s:c:")) != -1) {
+		switch (opt) {
+		case 't' :
+			run_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 's' :
+			script = optarg;
+			break;
+		case 'c' :
+			capture_path = optarg;
+			break;
+		default :
+			usage(argv[0]);
+		}
+	}
+
+	hal_host_init(run_ms);
+	if (script && hal_host_script(script))
+		return EXIT_FAILURE;
+	if (capture_path && capture_create(&capture, capture_path, 0))
+		return EXIT_FAILURE;
+
+	tlc_model_init(&tlc);
+	hal_host_watch_port(watch_port);
+	hal_host_at_end(end);
+
+	return firmware_main();
+}
@@ -0,0 +1,33 @@
+#include "hal.h"
+#include "input.h"
+#include "debounce.h"
+#include "events.h"
+
+static gesture_t button;
+static debounce_t slide;
+
+uint8_t input_init (void) {
+	uint8_t pins = hal_pins();
+
+	gesture_init(&button, (pins & BUTTON_PIN) != 0);
+	debounce_init(&slide, pins & SWITCH_PINS);
+
+	hal_timer2_init(F_CPU/256/INPUT_HZ - 1);
+
+	return slide.stable;
+}
+
+HAL_ISR(TIMER2_COMPA) {
+	uint8_t pins = hal_pins();
+	uint8_t g;
+
+	g = gesture_sample(&button, (pins & BUTTON_PIN) != 0);
+	if (g)
+		event_post(EV_BUTTON, g);
+
+	if (debounce(&slide, pins & SWITCH_PINS))
+		event_post(EV_SWITCH, slide.stable);
+}
+
+// Only here to wake us from power down
+HAL_EMPTY_ISR(PCINT2);
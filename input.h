@@ -0,0 +1,38 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+
+#include "tlc5947.h"
+#include "debounce.h"
+
+/*
+   Button and slide switch
+
+   Timer2 samples the pins every DEBOUNCE_SAMPLE_MS and runs them through
+   debounce.c.  The button's gestures are posted as EV_BUTTON events and the
+   debounced slide switch pins as EV_SWITCH events.  The pin change
+   interrupts are only used to wake up from power down, Timer2 doesn't run
+   then.
+*/
+
+#define INPUT_HZ (1000 / DEBOUNCE_SAMPLE_MS)
+
+#define BUTTON_PIN     (1 << PIND7)
+#define SWITCH_OFF_PIN   (1 << PIND4)
+#define SWITCH_SENSE_PIN (1 << PIND5)
+#define SWITCH_ON_PIN    (1 << PIND6)
+
+// Slide switch pins we watch.  PCINT20-22 are PD4-PD6, so this is also their
+// pin change mask.  With the USART backend PD4 is the shift clock, so only the
+// SENSE and ON positions are watched.
+#if TLC_BACKEND == TLC_BACKEND_USART
+#define SWITCH_PINS (SWITCH_SENSE_PIN | SWITCH_ON_PIN)
+#else
+#define SWITCH_PINS (SWITCH_OFF_PIN | SWITCH_SENSE_PIN | SWITCH_ON_PIN)
+#endif
+
+// Start sampling.  Returns the slide switch pins as they are now.
+uint8_t input_init(void);
+
+#endif
@@ -0,0 +1,41 @@
+#include "light.h"
+
+#define LIGHT_DWELL (LIGHT_DWELL_MS / LIGHT_SAMPLE_MS)
+
+void light_init (light_t *l) {
+	l->acc = 0;
+	l->state = LIGHT_UNKNOWN;
+	l->dwell = 0;
+}
+
+uint8_t light_update (light_t *l, uint16_t sample) {
+	uint8_t want;
+
+	// Start the average at the first sample and go with it straight away
+	if (l->state == LIGHT_UNKNOWN) {
+		l->acc = sample << LIGHT_EMA_SHIFT;
+		l->state = sample > LIGHT_OFF_ABOVE ? LIGHT_OFF : LIGHT_ON;
+		return 1;
+	}
+
+	// The sum can go negative part way, but it always ends up in range
+	l->acc += sample - (l->acc >> LIGHT_EMA_SHIFT);
+
+	want = l->state;
+	if (l->state == LIGHT_ON && light_level(l) > LIGHT_OFF_ABOVE)
+		want = LIGHT_OFF;
+	else if (l->state == LIGHT_OFF && light_level(l) < LIGHT_ON_BELOW)
+		want = LIGHT_ON;
+
+	if (want == l->state) {
+		l->dwell = 0;
+		return 0;
+	}
+
+	if (++l->dwell < LIGHT_DWELL)
+		return 0;
+
+	l->state = want;
+	l->dwell = 0;
+	return 1;
+}
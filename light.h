@@ -0,0 +1,52 @@
+#ifndef LIGHT_H
+#define LIGHT_H
+
+#include <stdint.h>
+
+#include "adc.h"
+
+/*
+   Ambient light filter for sense mode
+
+   Each light sensor result (12 bits, one every LIGHT_SAMPLE_MS) goes into an
+   exponential moving average, new = old + (sample - old)/2^LIGHT_EMA_SHIFT,
+   kept scaled up by 2^LIGHT_EMA_SHIFT so nothing is lost to rounding.  The
+   lights go off once the average climbs over LIGHT_OFF_ABOVE and come back
+   once it falls under LIGHT_ON_BELOW.  Either way it has to stay past the
+   threshold for LIGHT_DWELL_MS first, so a passing headlight or the sensor
+   hovering at dusk doesn't make the lights flicker.
+
+   None of this touches the hardware, so it runs the same on the host.
+*/
+
+#define LIGHT_SAMPLE_MS (ADC_SAMPLE_MS * ADC_OVERSAMPLE)
+
+#define LIGHT_EMA_SHIFT 4
+
+// The old single threshold was 260 of 10 bits, 1040 of 12
+#define LIGHT_OFF_ABOVE 1100
+#define LIGHT_ON_BELOW  980
+
+#define LIGHT_DWELL_MS 2000
+
+#define LIGHT_UNKNOWN 0		// No sample yet
+#define LIGHT_ON      1		// Dark enough, lights on
+#define LIGHT_OFF     2		// Too bright, lights off
+
+typedef struct {
+	uint16_t acc;		// The average, times 2^LIGHT_EMA_SHIFT
+	uint8_t state;
+	uint8_t dwell;		// Samples it has been past the threshold
+} light_t;
+
+void light_init(light_t *l);
+
+// Feed one sample, returns 1 when the state changes
+uint8_t light_update(light_t *l, uint16_t sample);
+
+// The filtered level, 12 bits
+static inline uint16_t light_level (const light_t *l) {
+	return l->acc >> LIGHT_EMA_SHIFT;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <stdint.h>
+
+#include "tlc5947.h"
+
+/*
+   Palette-indexed frames
+
+   Instead of its own 12 bit red, green and blue, each LED holds an index
+   into a small table of colors.  An effect that changes every LED the same
+   way then only has to update a palette entry, not redraw all eight LEDs,
+   e.g. a hue sweep is one hsv2rgb() a frame.
+
+   Nothing is packed into TLC5947 order until the compositor blends the
+   layer into the output frame (blend_palette() in blend.c), so a palette
+   frame never has to be expanded on its own.  Indexes must be below
+   PALETTE_SIZE.
+*/
+
+#define PALETTE_SIZE 4
+#define PALETTE_LEDS (TLC_CHANNELS/3)
+
+typedef struct {
+	uint16_t rgb[PALETTE_SIZE][3];
+	uint8_t index[PALETTE_LEDS];
+} palette_frame_t;
+
+static inline void palette_set (palette_frame_t *p, uint8_t entry, uint16_t r, uint16_t g, uint16_t b) {
+	p->rgb[entry][0] = r;
+	p->rgb[entry][1] = g;
+	p->rgb[entry][2] = b;
+}
+
+// Point an LED at a palette entry.  Like tlc_set_rgb(), idx is the LED's
+// first channel as in the LED tables.
+static inline void palette_set_idx (palette_frame_t *p, uint8_t idx, uint8_t entry) {
+	p->index[idx / 3] = entry;
+}
+
+static inline void palette_set_led (palette_frame_t *p, uint8_t led, uint8_t entry) {
+	p->index[led] = entry;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#include "programs.h"
+#include "color.h"
+
+/*
+
+ === Color Cycle Prog ===
+
+ Every LED shows palette entry 0, so a frame is one hsv2rgb() into it.
+
+*/
+
+// About 0.001 of a turn
+#define COLOR_CYCLE_HUE_STEP 66
+
+void color_cycle_init (void *state, tlc_frame_t *f) {
+}
+
+void color_cycle_step (void *state, tlc_frame_t *f) {
+	color_cycle_state_t *st = state;
+	uint16_t r, g, b;
+
+	hsv2rgb(st->hue, HSV_MAX, HSV_MAX, &r, &g, &b);
+	palette_set(&st->pal, 0, r, g, b);
+
+	st->hue += COLOR_CYCLE_HUE_STEP;
+}
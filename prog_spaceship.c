@@ -0,0 +1,72 @@
+#include <avr/pgmspace.h>
+
+#include "programs.h"
+#include "color.h"
+#include "comet.h"
+
+/*
+
+ === Spaceship Prog ===
+
+ One comet with a one LED tail round each ring, the bottom ring half a turn
+ round the color wheel from the top.  The rings take turns being bright: the
+ top ring's heads rise to the envelope and the bottom ring's to what's left
+ of it.
+
+*/
+
+// About 0.0004 of a turn, and of the envelope, per frame
+#define SS_HUE_STEP 26
+#define SS_ENV_STEP 26
+
+const uint8_t spaceship_cycles[2][4] PROGMEM = {
+	{5*3, 6*3, 0*3, 3*3},
+	{1*3, 7*3, 4*3, 2*3},
+};
+
+// Heads rise and tails fade about 0.004 of full per frame
+const comet_path_t spaceship_paths[2] PROGMEM = {
+	{spaceship_cycles[0], 4, 1, 0, 1, 16, 16, HSV_MAX, 0},
+	{spaceship_cycles[1], 4, 1, 2, 1, 16, 16, HSV_MAX, HUE_TURN/2},
+};
+
+void spaceship_init (void *state, tlc_frame_t *f) {
+	spaceship_state_t *st = state;
+
+	comet_init(&st->ring[0], &spaceship_paths[0]);
+	comet_init(&st->ring[1], &spaceship_paths[1]);
+
+	// Start with the top ring at full and on the way down
+	st->env = 0xFFFF;
+	st->env_dir = -1;
+}
+
+void spaceship_step (void *state, tlc_frame_t *f) {
+	spaceship_state_t *st = state;
+
+	comet_step(&st->ring[0], &spaceship_paths[0], st->env >> 4);
+	comet_step(&st->ring[1], &spaceship_paths[1], (0xFFFF - st->env) >> 4);
+
+	comet_draw(&st->ring[0], &spaceship_paths[0], st->hue, f);
+	comet_draw(&st->ring[1], &spaceship_paths[1], st->hue, f);
+
+	// Wraps around on its own
+	st->hue += SS_HUE_STEP;
+
+	// Triangle wave between 0 and full
+	if (st->env_dir > 0) {
+		if (st->env > 0xFFFF - SS_ENV_STEP) {
+			st->env = 0xFFFF;
+			st->env_dir = -1;
+		} else {
+			st->env += SS_ENV_STEP;
+		}
+	} else {
+		if (st->env < SS_ENV_STEP) {
+			st->env = 0;
+			st->env_dir = 1;
+		} else {
+			st->env -= SS_ENV_STEP;
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#include "programs.h"
+#include "color.h"
+#include "sun.h"
+
+/*
+
+ === Sun Show Prog ===
+
+*/
+
+// Where the day had got to, kept outside the arena so the show picks up
+// there when it's started again
+static uint16_t saved_day = 0;
+
+void sun_show_init (void *state, tlc_frame_t *f) {
+	sun_show_state_t *st = state;
+
+	sun_seek(&st->sun, saved_day);
+}
+
+void sun_show_step (void *state, tlc_frame_t *f) {
+	sun_show_state_t *st = state;
+	uint16_t h, s, v;
+	uint16_t r, g, b;
+
+	for (uint8_t band = 0; band < SUN_BANDS; band++) {
+		sun_band_hsv(&st->sun, band, &h, &s, &v);
+		hsv2rgb(h, s, v, &r, &g, &b);
+
+		// Each ring has a couple of LEDs.  Set the RGB for each
+		for (uint8_t x = 0; x < SUN_BAND_LEDS && sun_ring(band, x) != SUN_NO_LED; x++)
+			tlc_set_rgb(f, sun_ring(band, x), r, g, b);
+	}
+
+	// Move on a frame, this wraps around at DAY_FRAMES frames.
+	sun_advance(&st->sun);
+	saved_day = sun_day(&st->sun);
+}
@@ -0,0 +1,106 @@
+#include <avr/pgmspace.h>
+
+#include "programs.h"
+
+/*
+
+ === XMAS BALL PROG ===
+
+*/
+
+#define XBALL_LIGHT_LIMIT 0xFFF
+
+// This pattern lights LEDs 1,3,4,6 together and 0,2,5,7 together 
+const uint8_t xmas_ball_sets[2][4] PROGMEM = {
+	{1*3, 3*3, 4*3, 6*3},
+	{0*3, 2*3, 5*3, 7*3},
+};
+
+static inline uint8_t xball_set (uint8_t set, uint8_t n) {
+	return pgm_read_byte(&xmas_ball_sets[set][n]);
+}
+
+// Palette entries
+#define XBALL_OFF   0
+#define XBALL_COLOR 1
+#define XBALL_WHITE 2
+
+// Point a set of lights at a palette entry
+static void xball_show (xmas_ball_state_t *st, uint8_t set, uint8_t entry) {
+	for (uint8_t x = 0; x <= 3; x++)
+		palette_set_idx(&st->pal, xball_set(set, x), entry);
+}
+
+void xmas_ball_init (void *state, tlc_frame_t *f) {
+	xmas_ball_state_t *st = state;
+
+	st->light_step = 0x001;
+	st->light_max = XBALL_LIGHT_LIMIT;
+
+	xball_show(st, st->light_set, XBALL_COLOR);
+}
+
+void xmas_ball_step (void *state, tlc_frame_t *f) {
+	xmas_ball_state_t *st = state;
+
+	// Phase 1; warm up the color
+	if (st->phase == 0) {
+		palette_set(&st->pal, XBALL_COLOR,
+				st->light_level[0],
+				st->light_level[1],
+				st->light_level[2]);
+
+		st->light_level[st->light_color] += st->light_step;
+
+		// Hold at the top, tlc_set() only keeps 12 bits
+		if (st->light_level[st->light_color] > st->light_max) {
+			st->light_level[st->light_color] = st->light_max;
+			st->phase = 1;
+			xball_show(st, (st->light_set+1)%2, XBALL_WHITE);
+		}
+	}
+	// Phase 2; warm up the white
+	else if (st->phase == 1) {
+		palette_set(&st->pal, XBALL_WHITE,
+				st->white_level,
+				st->white_level,
+				st->white_level);
+
+		st->white_level += st->light_step;
+
+		if (st->white_level > st->light_max) {
+			st->white_level = st->light_max;
+			st->phase = 2;
+		}
+	} else {
+		palette_set(&st->pal, XBALL_COLOR,
+				st->light_level[0],
+				st->light_level[1],
+				st->light_level[2]);
+		palette_set(&st->pal, XBALL_WHITE,
+				st->white_level,
+				st->white_level,
+				st->white_level);
+
+		// Stop at zero rather than wrap round
+		if (st->light_level[st->light_color] > st->light_step*4)
+			st->light_level[st->light_color] -= st->light_step*4;
+		else
+			st->light_level[st->light_color] = 0;
+		if (st->white_level > st->light_step*4)
+			st->white_level -= st->light_step*4;
+		else
+			st->white_level = 0;
+
+		if (st->light_level[st->light_color] == 0 && st->white_level == 0) {
+			xball_show(st, st->light_set, XBALL_OFF);
+			st->light_level[0] = st->light_level[1] = st->light_level[2] = 0;
+			st->light_set = (st->light_set + 1) % 2;
+			st->light_color = (st->light_color + 1) % 3;
+
+			st->white_level = 0;
+			st->phase = 0;
+			xball_show(st, st->light_set, XBALL_COLOR);
+		}
+	}
+}
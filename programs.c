@@ -0,0 +1,25 @@
+#include <avr/pgmspace.h>
+
+#include "programs.h"
+#include "blend.h"
+
+const program_t programs[NUM_PROGRAMS] PROGMEM = {
+	{sun_show_init,    sun_show_step,    20, sizeof(sun_show_state_t),    0},
+	{spaceship_init,   spaceship_step,   10, sizeof(spaceship_state_t),   0},
+	{xmas_ball_init,   xmas_ball_step,    5, sizeof(xmas_ball_state_t),   PROG_PALETTE},
+	{color_cycle_init, color_cycle_step, 50, sizeof(color_cycle_state_t), PROG_PALETTE},
+};
+
+const scene_t scenes[NUM_SCENES] PROGMEM = {
+	{1, {{PROG_SUN_SHOW,    LEDS_ALL, BLEND_REPLACE, 0}}},
+	{1, {{PROG_SPACESHIP,   LEDS_ALL, BLEND_REPLACE, 0}}},
+	{1, {{PROG_XMAS_BALL,   LEDS_ALL, BLEND_REPLACE, 0}}},
+	{1, {{PROG_COLOR_CYCLE, LEDS_ALL, BLEND_REPLACE, 0}}},
+	// The sun show on the bottom ring under the spaceship on top
+	{2, {{PROG_SUN_SHOW,    LEDS_BOTTOM, BLEND_REPLACE, 0},
+	     {PROG_SPACESHIP,   LEDS_TOP,    BLEND_REPLACE, 0}}},
+};
+
+const uint16_t dimmer_levels[DIMMER_STEPS] PROGMEM = {
+	4096, 2896, 2048, 1448, 1024, 724, 512, 362, 256, 181, 128, 91,
+};
@@ -0,0 +1,152 @@
+#ifndef PROGRAMS_H
+#define PROGRAMS_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "tlc5947.h"
+#include "sun.h"
+#include "comet.h"
+#include "palette.h"
+
+/*
+   Program registry
+
+   Each animation is described by a program_t in flash: init() sets up its
+   state, step() draws one frame into f and moves on, period is its frame
+   period in milliseconds and state_size how much of the state arena it uses.
+
+   Programs keep their state in an arena, a union of their state structs, so
+   a slot can hold any of them and costs the RAM of the biggest rather than
+   the sum.  The compositor has one arena per layer.  The arena is zeroed
+   before init(), which then sets up whatever isn't meant to start at zero.
+   Nothing survives a switch to another program except what a program
+   deliberately keeps outside the arena.
+
+   A program with PROG_PALETTE in its flags draws into a palette_frame_t
+   (palette.h) at the start of its state instead of into f, and the
+   compositor expands it as it blends the layer.
+
+   What the button steps through are scenes: up to SCENE_LAYERS programs run
+   together, each drawn onto the LEDs in its mask with a blend mode from
+   blend.h, bottom layer first.  A plain program is a scene of one layer.
+
+   To add a program, give it a state struct below, add that to
+   program_state_t, add its descriptor to programs[] in programs.c and give
+   it a scene in scenes[].
+*/
+
+typedef struct {
+	void (*init)(void *state, tlc_frame_t *f);
+	void (*step)(void *state, tlc_frame_t *f);
+	uint8_t period;
+	uint8_t state_size;
+	uint8_t flags;
+} program_t;
+
+#define PROG_PALETTE 0x01
+
+typedef struct {
+	sun_t sun;
+} sun_show_state_t;
+
+typedef struct {
+	// A comet round each ring, top then bottom
+	comet_t ring[2];
+
+	uint16_t hue;
+
+	// Brightness envelope, 16 bit, and which way it's going
+	uint16_t env;
+	int8_t env_dir;
+} spaceship_state_t;
+
+typedef struct {
+	// Palette mode; entry 1 is the color, 2 the white
+	palette_frame_t pal;
+
+	// Current intensity of the light, and the color to cycle through (r=0,
+	// g=1, b=2)
+	uint16_t light_level[3];
+	uint8_t light_color;
+
+	// How much to raise the current level per frame, and the top
+	uint16_t light_step;
+	uint16_t light_max;
+
+	// The set of lights to illuminate, and which phase we're in
+	uint8_t light_set;
+	uint8_t phase;
+
+	// Current level of the white phase
+	uint16_t white_level;
+} xmas_ball_state_t;
+
+typedef struct {
+	// Palette mode, every LED shows entry 0
+	palette_frame_t pal;
+	uint16_t hue;
+} color_cycle_state_t;
+
+typedef union {
+	sun_show_state_t sun_show;
+	spaceship_state_t spaceship;
+	xmas_ball_state_t xmas_ball;
+	color_cycle_state_t color_cycle;
+
+	// What a PROG_PALETTE program's state starts with
+	palette_frame_t palette;
+} program_state_t;
+
+#define PROG_SUN_SHOW    0
+#define PROG_SPACESHIP   1
+#define PROG_XMAS_BALL   2
+#define PROG_COLOR_CYCLE 3
+#define NUM_PROGRAMS     4
+
+extern const program_t programs[NUM_PROGRAMS] PROGMEM;
+
+// LED masks, bit n is LED n.  The rings are the ones in spaceship_cycles.
+#define LEDS_ALL    0xFF
+#define LEDS_TOP    ((1 << 0) | (1 << 3) | (1 << 5) | (1 << 6))
+#define LEDS_BOTTOM ((1 << 1) | (1 << 2) | (1 << 4) | (1 << 7))
+
+#define SCENE_LAYERS 2
+
+typedef struct {
+	uint8_t program;	// Index into programs[]
+	uint8_t mask;		// LEDs it draws on
+	uint8_t mode;		// BLEND_*
+	uint16_t alpha;		// For BLEND_ALPHA, out of BLEND_ONE
+} layer_def_t;
+
+typedef struct {
+	uint8_t layers;
+	layer_def_t layer[SCENE_LAYERS];
+} scene_t;
+
+#define NUM_SCENES 5
+
+extern const scene_t scenes[NUM_SCENES] PROGMEM;
+
+// Master dimmer steps, 3dB apart, out of TLC_DIMMER_MAX.  A long press
+// walks down them to the dimmest and then back up.
+#define DIMMER_STEPS 12
+
+extern const uint16_t dimmer_levels[DIMMER_STEPS] PROGMEM;
+
+// Copy a descriptor out of flash
+static inline void program_get (const program_t *p, program_t *out) {
+	memcpy_P(out, p, sizeof(*out));
+}
+
+void sun_show_init(void *state, tlc_frame_t *f);
+void sun_show_step(void *state, tlc_frame_t *f);
+void spaceship_init(void *state, tlc_frame_t *f);
+void spaceship_step(void *state, tlc_frame_t *f);
+void xmas_ball_init(void *state, tlc_frame_t *f);
+void xmas_ball_step(void *state, tlc_frame_t *f);
+void color_cycle_init(void *state, tlc_frame_t *f);
+void color_cycle_step(void *state, tlc_frame_t *f);
+
+#endif
@@ -0,0 +1,146 @@
+#include "hal.h"
+#include "sched.h"
+
+sched_stats_t sched_stats;
+
+static volatile uint16_t ticks = 0;
+
+static uint16_t period = 1;
+static uint16_t deadline;
+static uint16_t last_frame;
+
+// Timer1 counts slept since the last frame, and when that frame started
+static uint16_t asleep;
+static uint16_t frame_stamp;
+
+// When we woke from power down, until the first frame after it
+static uint16_t wake_stamp;
+static uint8_t waking = 0;
+
+void sched_init (void) {
+	hal_timer1_init(SCHED_TICK_COUNTS - 1);
+}
+
+HAL_ISR(TIMER1_COMPA) {
+	ticks++;
+}
+
+// Time in Timer1 counts.  This wraps, so only differences under about half a
+// second mean anything.  Call with interrupts off.
+static uint16_t stamp (void) {
+	uint16_t count = hal_timer1_count();
+	uint16_t t = ticks;
+
+	// The compare match has happened but its interrupt hasn't run yet
+	if (hal_timer1_pending() && count < SCHED_TICK_COUNTS/2)
+		t++;
+
+	return t * SCHED_TICK_COUNTS + count;
+}
+
+uint16_t sched_now (void) {
+	uint16_t now;
+
+	HAL_ATOMIC {
+		now = ticks;
+	}
+	return now;
+}
+
+uint16_t sched_clock (void) {
+	uint16_t t;
+
+	HAL_ATOMIC {
+		t = stamp();
+	}
+	return t;
+}
+
+void sched_set_period (uint16_t p) {
+	period = p ? p : 1;
+	deadline = last_frame = sched_now();
+	sched_stats.max_period = 0;
+
+	frame_stamp = sched_clock();
+	asleep = 0;
+}
+
+uint8_t sched_frame_due (void) {
+	uint16_t now = sched_now();
+
+	if ((int16_t) (now - deadline) < 0)
+		return 0;
+
+	sched_stats.period = now - last_frame;
+	if (sched_stats.period > sched_stats.max_period)
+		sched_stats.max_period = sched_stats.period;
+	last_frame = now;
+
+	// Duty cycle of the frame that just finished.  After a long gap (the
+	// switch was off) the stamps have wrapped, so don't trust the sleep
+	// count to be smaller than the frame.
+	uint16_t t = sched_clock();
+	uint16_t elapsed = t - frame_stamp;
+	if (elapsed == 0 || asleep >= elapsed)
+		sched_stats.awake = 0;
+	else
+		sched_stats.awake = (uint32_t) (elapsed - asleep) * 100 / elapsed;
+	frame_stamp = t;
+	asleep = 0;
+
+	if (waking) {
+		sched_stats.wake_latency = t - wake_stamp;
+		waking = 0;
+	}
+
+	deadline += period;
+
+	// More than a whole frame behind, don't try to catch up
+	if ((int16_t) (now - deadline) >= 0) {
+		sched_stats.missed++;
+		deadline = now + period;
+	}
+
+	return 1;
+}
+
+#if SCHED_SLEEP
+// Sleep in idle, which keeps the timers and the USART/SPI running.  Called
+// with interrupts off, returns with them off.
+static void doze (void) {
+	uint16_t t = stamp();
+
+	hal_sleep(HAL_SLEEP_IDLE);
+
+	// The interrupt that woke us has already run, its time counts as
+	// asleep.  That's a few microseconds per wakeup.
+	hal_irq_disable();
+	t = stamp() - t;
+	asleep = (asleep + t < asleep) ? 0xFFFF : asleep + t;
+}
+#endif
+
+void sched_idle (void) {
+#if SCHED_SLEEP
+	// Check and sleep with interrupts off, otherwise the tick that makes the
+	// frame due could land between the two and we would sleep through it.
+	hal_irq_disable();
+	if ((int16_t) (ticks - deadline) < 0)
+		doze();
+	hal_irq_enable();
+#endif
+}
+
+void sched_sleep (void) {
+#if SCHED_SLEEP
+	hal_irq_disable();
+	doze();
+	hal_irq_enable();
+#endif
+}
+
+void sched_resume (void) {
+	wake_stamp = sched_clock();
+	waking = 1;
+	sched_set_period(period);
+}
@@ -0,0 +1,72 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+
+/*
+   Frame scheduler
+
+   Timer1 runs in CTC mode and ticks at SCHED_HZ.  The main loop asks
+   sched_frame_due() whether the current program's next frame is due, so the
+   frame period no longer depends on how long the program took to draw.
+   Deadlines advance by exactly one period per frame; if a frame starts more
+   than a whole period late the deadline restarts from now and the miss is
+   counted.
+
+   Between frames the main loop calls sched_idle(), which puts the CPU into
+   SLEEP_MODE_IDLE until the next interrupt.  Timer1 keeps running in idle,
+   so the worst case is waking once a tick.  Build with SCHED_SLEEP=0 to spin
+   instead, the way the old delay loops did.
+
+   The time spent asleep is measured off TCNT1 (8us per count at 8MHz), and
+   each frame reports what percentage of the time since the previous frame
+   the CPU was awake.  The busy-wait build always reports 100.
+*/
+
+#ifndef SCHED_SLEEP
+#define SCHED_SLEEP 1
+#endif
+
+#define SCHED_HZ 1000
+
+// Timer1 counts per tick
+#define SCHED_TICK_COUNTS (F_CPU/64/SCHED_HZ)
+
+// Convert milliseconds to scheduler ticks
+#define SCHED_MS(ms) ((uint16_t) ((uint32_t) (ms) * SCHED_HZ / 1000))
+
+typedef struct {
+	uint16_t period;	// Ticks between the last two frames
+	uint16_t max_period;	// Longest gap seen since the period was set
+	uint16_t missed;	// Frames that started more than a period late
+	uint8_t awake;		// Percent of the last frame the CPU was awake
+	uint16_t wake_latency;	// Timer1 counts from the last power down wakeup
+				// to the first frame after it
+} sched_stats_t;
+
+extern sched_stats_t sched_stats;
+
+void sched_init(void);
+uint16_t sched_now(void);
+
+// Free running time in Timer1 counts (8us at 8MHz), for timing short pieces
+// of code.  It wraps about every half second.
+uint16_t sched_clock(void);
+
+// Set the frame period, the next frame is due straight away
+void sched_set_period(uint16_t ticks);
+uint8_t sched_frame_due(void);
+
+// Sleep until the next interrupt, unless the next frame is already due
+void sched_idle(void);
+
+// Sleep until the next interrupt, for when no frames are being drawn and
+// the deadline means nothing
+void sched_sleep(void);
+
+// Restart the frame clock after a power down (Timer1 stops while powered
+// down).  The next frame is due straight away, and the time until it starts
+// is kept in sched_stats.wake_latency.
+void sched_resume(void);
+
+#endif
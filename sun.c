@@ -0,0 +1,48 @@
+#include <avr/pgmspace.h>
+
+#include "sun.h"
+
+static void start_hour (sun_t *sun, uint8_t hour, uint16_t offset) {
+	sun_segment_t seg;
+	uint8_t band, x;
+
+	for (band = 0; band < SUN_BANDS; band++) {
+		memcpy_P(&seg, &sun_segments[band][hour], sizeof(seg));
+
+		// Catch up if we're starting part way through the hour
+		for (x = 0; x <= 2; x++) {
+			sun->step[band][x] = seg.step[x];
+			sun->hsv[band][x]  = seg.start[x] + seg.step[x] * (int32_t) offset;
+		}
+	}
+
+	sun->hour_left = HOUR_INTERVAL - offset;
+}
+
+void sun_seek (sun_t *sun, uint16_t d) {
+	sun->day = d % DAY_FRAMES;
+	start_hour(sun, sun->day / HOUR_INTERVAL, sun->day % HOUR_INTERVAL);
+}
+
+void sun_advance (sun_t *sun) {
+	uint8_t band, x;
+
+	if (++sun->day == DAY_FRAMES)
+		sun->day = 0;
+
+	// At the top of the hour start fading towards the next keyframe
+	if (--sun->hour_left == 0) {
+		start_hour(sun, sun->day / HOUR_INTERVAL, 0);
+		return;
+	}
+
+	for (band = 0; band < SUN_BANDS; band++)
+		for (x = 0; x <= 2; x++)
+			sun->hsv[band][x] += sun->step[band][x];
+}
+
+void sun_band_hsv (const sun_t *sun, uint8_t band, uint16_t *h, uint16_t *s, uint16_t *v) {
+	*h = sun->hsv[band][0] >> 16;
+	*s = sun->hsv[band][1] >> 16;
+	*v = sun->hsv[band][2] >> 16;
+}
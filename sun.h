@@ -0,0 +1,51 @@
+#ifndef SUN_H
+#define SUN_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// DAY_FRAMES, DAY_SEGMENTS, SUN_BANDS and the tables come from sun_bands.txt
+#include "sun_table.h"
+
+/*
+   Sun show keyframe engine
+
+   Each band fades from one keyframe ("hour") to the next over HOUR_INTERVAL
+   frames.  tools/sunc works out where every fade starts and how much it
+   moves per frame when the firmware is built, so at the top of each hour the
+   engine just loads the next segment and after that sun_advance() only adds
+   the per-frame steps.  The band colors come out in the fixed point HSV of
+   color.h.
+
+   The engine keeps no state of its own, it all lives in the caller's sun_t.
+*/
+
+typedef struct {
+	// Where the day is, and the frames left until the next keyframe
+	uint16_t day;
+	uint16_t hour_left;
+
+	// Each band's hue, saturation and value with 16 fraction bits, and how
+	// much they move per frame.  Hue wraps around at 32 bits, a full turn.
+	uint32_t hsv[SUN_BANDS][3];
+	int32_t  step[SUN_BANDS][3];
+} sun_t;
+
+// Jump to any frame of the day, e.g. when the program is (re)started
+void sun_seek(sun_t *sun, uint16_t day);
+
+// Move on one frame, wrapping around at DAY_FRAMES
+void sun_advance(sun_t *sun);
+
+static inline uint16_t sun_day (const sun_t *sun) {
+	return sun->day;
+}
+
+// TLC5947 channel of the n'th LED in a band, or SUN_NO_LED
+static inline uint8_t sun_ring (uint8_t band, uint8_t n) {
+	return pgm_read_byte(&sun_rings[band][n]);
+}
+
+void sun_band_hsv(const sun_t *sun, uint8_t band, uint16_t *h, uint16_t *s, uint16_t *v);
+
+#endif
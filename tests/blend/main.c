@@ -0,0 +1,145 @@
+/*
+   Host test for the compositor blend kernels in blend.c
+
+   Runs every pair of 12 bit values through the add, multiply and alpha
+   kernels and compares them with the same sums done in floating point, then
+   blends made up frames through blend_leds() and checks that only the LEDs
+   in the mask change, and that blend_palette() gives the same as expanding
+   the palette frame by hand and blending that.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "blend.h"
+
+static int failures = 0;
+
+static void check_kernels (void) {
+	static const uint16_t alphas[] = {0, 1, 0x400, 0x800, 0xC00, 0xFFF, BLEND_ONE};
+	int worst_mul = 0, worst_alpha = 0;
+
+	for (int d = 0; d <= BLEND_MAX; d++) {
+		for (int s = 0; s <= BLEND_MAX; s++) {
+			int want, err;
+
+			want = d + s > BLEND_MAX ? BLEND_MAX : d + s;
+			if (blend_add(d, s) != want) {
+				if (failures++ < 10)
+					printf("add %d %d = %d, expected %d  FAIL\n", d, s, blend_add(d, s), want);
+			}
+
+			want = lround((double) d * s / BLEND_MAX);
+			err = abs(blend_multiply(d, s) - want);
+			if (err > worst_mul)
+				worst_mul = err;
+
+			for (unsigned a = 0; a < sizeof(alphas)/sizeof(alphas[0]); a++) {
+				want = lround(d + (s - d) * (double) alphas[a] / BLEND_ONE);
+				err = abs(blend_alpha(d, s, alphas[a]) - want);
+				if (err > worst_alpha)
+					worst_alpha = err;
+			}
+		}
+
+		// The ends have to be exact
+		if (blend_multiply(d, BLEND_MAX) != d || blend_multiply(d, 0) != 0 ||
+				blend_alpha(d, 0x123, 0) != d || blend_alpha(d, 0x123, BLEND_ONE) != 0x123) {
+			printf("multiply or alpha end point wrong at %d  FAIL\n", d);
+			failures++;
+		}
+	}
+
+	printf("worst multiply error %d counts, worst alpha error %d counts\n", worst_mul, worst_alpha);
+	if (worst_mul > 1 || worst_alpha > 1) {
+		printf("  FAIL, should be within 1 count\n");
+		failures++;
+	}
+}
+
+static void fill (tlc_frame_t *f, uint16_t base) {
+	for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++)
+		tlc_set(f, ch, (base + ch * 97) & BLEND_MAX);
+}
+
+static void check_masks (void) {
+	static const uint8_t masks[] = {0x00, 0x01, 0x80, 0x69, 0x96, 0xFF};
+	tlc_frame_t dst, src, was;
+
+	for (unsigned m = 0; m < sizeof(masks); m++) {
+		for (uint8_t mode = BLEND_REPLACE; mode <= BLEND_ALPHA; mode++) {
+			fill(&dst, 0x321);
+			fill(&src, 0xA05);
+			was = dst;
+
+			blend_leds(&dst, &src, masks[m], mode, 0x800);
+
+			for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++) {
+				uint16_t d = tlc_get(&was, ch), s = tlc_get(&src, ch);
+				uint16_t want = d;
+
+				if (masks[m] & (1 << (ch / 3))) {
+					switch (mode) {
+					case BLEND_REPLACE :  want = s; break;
+					case BLEND_ADD :      want = blend_add(d, s); break;
+					case BLEND_MULTIPLY : want = blend_multiply(d, s); break;
+					case BLEND_ALPHA :    want = blend_alpha(d, s, 0x800); break;
+					}
+				}
+
+				if (tlc_get(&dst, ch) != want) {
+					printf("mask %02x mode %d channel %d = %03x, expected %03x  FAIL\n",
+						masks[m], mode, ch, tlc_get(&dst, ch), want);
+					failures++;
+				}
+			}
+		}
+	}
+
+	printf("blend_leds() masks checked\n");
+}
+
+static void check_palette (void) {
+	static const uint8_t masks[] = {0x00, 0x01, 0x80, 0x69, 0x96, 0xFF};
+	palette_frame_t pal;
+	tlc_frame_t src, want, got;
+
+	for (uint8_t e = 0; e < PALETTE_SIZE; e++)
+		palette_set(&pal, e, 0x111 * (e + 1), 0xFFF - 0x123 * e, 0x0F0 + 0x300 * e);
+
+	for (uint8_t led = 0; led < PALETTE_LEDS; led++) {
+		palette_set_led(&pal, led, (led * 3) % PALETTE_SIZE);
+		tlc_set_led(&src, led, pal.rgb[pal.index[led]][0], pal.rgb[pal.index[led]][1],
+			pal.rgb[pal.index[led]][2]);
+	}
+
+	for (unsigned m = 0; m < sizeof(masks); m++) {
+		for (uint8_t mode = BLEND_REPLACE; mode <= BLEND_ALPHA; mode++) {
+			fill(&want, 0x321);
+			got = want;
+
+			blend_leds(&want, &src, masks[m], mode, 0x500);
+			blend_palette(&got, &pal, masks[m], mode, 0x500);
+
+			if (memcmp(&want, &got, sizeof(want))) {
+				printf("palette mask %02x mode %d differs from the packed frame  FAIL\n",
+					masks[m], mode);
+				failures++;
+			}
+		}
+	}
+
+	printf("blend_palette() checked\n");
+}
+
+int main (void) {
+	check_kernels();
+	check_masks();
+	check_palette();
+
+	if (failures)
+		printf("%d check(s) failed\n", failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+/*
+   Host test for the comet engine in comet.c
+
+   Runs comets round made up paths, with a fixed and with a swinging target
+   level, and checks after every frame that the heads are where they should
+   be, stay evenly spaced, never go past the target, and that nothing more
+   than the tail length behind a head is lit.  Then checks comet_draw() only
+   touches the LEDs on its path.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "comet.h"
+#include "color.h"
+
+static int failures = 0;
+
+static const uint8_t ring4[4] PROGMEM = {5*3, 6*3, 0*3, 3*3};
+static const uint8_t ring8[8] PROGMEM = {0*3, 1*3, 2*3, 3*3, 4*3, 5*3, 6*3, 7*3};
+
+static const comet_path_t paths[] PROGMEM = {
+	{ring4, 4, 1, 2, 1, 16, 16, HSV_MAX, 0},
+	{ring8, 8, 2, 0, 2, 40, 100, HSV_MAX, 0},
+	{ring8, 8, 4, 1, 1, 255, 255, 0, 0},
+	{ring8, 8, 1, 0, 7, 7, 1, HSV_MAX, 0x4000},
+};
+
+#define NUM_PATHS (sizeof(paths) / sizeof(paths[0]))
+
+static void fail (int path, int frame, const char *what) {
+	if (failures++ < 10)
+		printf("path %d frame %d: %s  FAIL\n", path, frame, what);
+}
+
+static void run (int n, int swing) {
+	const comet_path_t *p = &paths[n];
+	comet_t c;
+	uint16_t target = 0xFFF;
+	uint8_t last;
+	int moves = 0;
+
+	comet_init(&c, p);
+	last = c.head[0];
+
+	for (int frame = 0; frame < 20000; frame++) {
+		// Either full, or a triangle between 0 and full
+		if (swing) {
+			int t = abs(frame * 3 % 0x2000 - 0x1000);
+			target = t > 0xFFF ? 0xFFF : t;
+		}
+
+		comet_step(&c, p, target);
+
+		for (int i = 0; i < p->len; i++) {
+			int behind = p->len;
+			for (int k = 0; k < p->comets; k++) {
+				int d = (c.head[k] + p->len - i) % p->len;
+				if (d < behind)
+					behind = d;
+			}
+
+			if (behind == 0 && c.level[i] > target)
+				fail(n, frame, "head past the target");
+			if (behind > p->tail && c.level[i] != 0)
+				fail(n, frame, "lit past the tail");
+			if (c.level[i] > HSV_MAX)
+				fail(n, frame, "level out of range");
+		}
+
+		for (int k = 1; k < p->comets; k++) {
+			if ((c.head[k] + p->len - c.head[k-1]) % p->len != p->len / p->comets)
+				fail(n, frame, "comets bunched up");
+		}
+
+		if (c.head[0] != last)
+			moves++;
+		last = c.head[0];
+	}
+
+	printf("path %d, %s target: head moved %d times\n", n, swing ? "swinging" : "full", moves);
+
+	// At full target a head moves on every target/rise frames, rounded up
+	if (!swing && moves != 20000 / ((0xFFF + p->rise - 1) / p->rise)) {
+		printf("  FAIL, expected %d\n", 20000 / ((0xFFF + p->rise - 1) / p->rise));
+		failures++;
+	}
+}
+
+static void check_draw (void) {
+	tlc_frame_t f;
+	comet_t c;
+
+	memset(&f, 0, sizeof(f));
+	for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++)
+		tlc_set(&f, ch, 0x555);
+
+	// Path 2 is white round all 8 LEDs, put them all at full
+	comet_init(&c, &paths[2]);
+	for (int i = 0; i < 8; i++)
+		c.level[i] = HSV_MAX;
+	comet_draw(&c, &paths[2], 0, &f);
+
+	for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++) {
+		if (tlc_get(&f, ch) != HSV_MAX) {
+			printf("channel %d = %03x after drawing the whole ring  FAIL\n", ch, tlc_get(&f, ch));
+			failures++;
+		}
+	}
+
+	memset(&f, 0, sizeof(f));
+	comet_draw(&c, &paths[0], 0, &f);
+	for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++) {
+		int on_path = ch/3 == 5 || ch/3 == 6 || ch/3 == 0 || ch/3 == 3;
+		if (!on_path && tlc_get(&f, ch) != 0) {
+			printf("channel %d is off the path but was drawn  FAIL\n", ch);
+			failures++;
+		}
+	}
+
+	printf("comet_draw() checked\n");
+}
+
+int main (void) {
+	for (unsigned n = 0; n < NUM_PATHS; n++) {
+		run(n, 0);
+		run(n, 1);
+	}
+	check_draw();
+
+	if (failures)
+		printf("%d check(s) failed\n", failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
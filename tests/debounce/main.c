@@ -0,0 +1,152 @@
+/*
+   Host test for the input debounce and button gestures in debounce.c
+
+   Each case is a scripted waveform, one sample per DEBOUNCE_SAMPLE_MS, with
+   contact bounce at the edges, and the gestures it must produce in order.
+   Waveforms are written as space separated runs, "level" or "level:count",
+   e.g. "1 0 1 1:40 0:100" is a two sample bounce, 40 samples down and 100
+   up.  The slide switch cases run whole pin values through debounce().
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debounce.h"
+
+#define MS(ms) ((ms) / DEBOUNCE_SAMPLE_MS)
+
+static int failures = 0;
+
+static const char *gesture_name (int g) {
+	switch (g) {
+	case GESTURE_SHORT :  return "short";
+	case GESTURE_LONG :   return "long";
+	case GESTURE_DOUBLE : return "double";
+	}
+	return "none";
+}
+
+// Play a waveform, give back the gestures and the sample each came on
+static int play (const char *wave, int *got, int *when, int max) {
+	gesture_t g;
+	int n = 0, t = 0;
+	char buf[512], *tok;
+
+	gesture_init(&g, 0);
+	strncpy(buf, wave, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = 0;
+
+	for (tok = strtok(buf, " "); tok; tok = strtok(NULL, " ")) {
+		int level = tok[0] - '0';
+		int count = strchr(tok, ':') ? atoi(strchr(tok, ':') + 1) : 1;
+
+		while (count--) {
+			int r = gesture_sample(&g, level);
+			if (r && n < max) {
+				got[n] = r;
+				when[n++] = t;
+			}
+			t++;
+		}
+	}
+	return n;
+}
+
+static void check (const char *name, const char *wave, const int *expect, int expected) {
+	int got[8], when[8];
+	int n = play(wave, got, when, 8);
+	int ok = n == expected;
+
+	for (int i = 0; ok && i < n; i++)
+		ok = got[i] == expect[i];
+
+	printf("%-26s", name);
+	for (int i = 0; i < n; i++)
+		printf(" %s@%dms", gesture_name(got[i]), when[i] * DEBOUNCE_SAMPLE_MS);
+	if (!n)
+		printf(" (nothing)");
+
+	if (!ok) {
+		printf("  FAIL, expected");
+		for (int i = 0; i < expected; i++)
+			printf(" %s", gesture_name(expect[i]));
+		failures++;
+	}
+	printf("\n");
+}
+
+#define CASE(name, wave, ...) do { \
+	static const int e[] = {__VA_ARGS__}; \
+	check(name, wave, e, sizeof(e)/sizeof(e[0]) - 1); \
+} while (0)
+
+// Sample by sample switch values, as the pins read
+static void check_switch (const char *name, const uint8_t *wave, int len, uint8_t expect, int changes) {
+	debounce_t d;
+	int n = 0;
+
+	debounce_init(&d, wave[0]);
+	for (int i = 0; i < len; i++)
+		n += debounce(&d, wave[i]);
+
+	printf("%-26s %02x after %d change(s)", name, d.stable, n);
+	if (d.stable != expect || n != changes) {
+		printf("  FAIL, expected %02x after %d", expect, changes);
+		failures++;
+	}
+	printf("\n");
+}
+
+int main (void) {
+	// The trailing 0 in each list only keeps the arrays non-empty
+	CASE("clean short",    "0:10 1:25 0:150",                         GESTURE_SHORT, 0);
+	CASE("bouncy short",   "0:10 1 0 1 0 0 1 1:25 0 1 0 1 0:150",     GESTURE_SHORT, 0);
+	CASE("single glitches", "0:10 1 0:40 1 1 0:40 1 0 1 0:100",       0);
+	CASE("too short to count",  "0:10 1 1 1 1 0 1 1 1 1 0:150", 0);
+	CASE("long",           "0:10 1 0 1:200 0 1 0:150",                GESTURE_LONG, 0);
+	CASE("long, held a while", "0:10 1:500 0 1 0:150",                GESTURE_LONG, 0);
+	CASE("double",         "0:10 1 0 1:25 0 1 0:30 1 0 1:25 0:150",   GESTURE_DOUBLE, 0);
+	CASE("double, second held", "0:10 1:25 0:30 1:300 0:150",         GESTURE_DOUBLE, 0);
+	CASE("two slow presses", "0:10 1:25 0:100 1:25 0:100",            GESTURE_SHORT, GESTURE_SHORT, 0);
+	CASE("short then long", "0:10 1:25 0:100 1 0 1:200 0:100",        GESTURE_SHORT, GESTURE_LONG, 0);
+
+	// Held at power up: nothing until it has been let go and pressed again
+	{
+		gesture_t g;
+		int r = 0;
+
+		gesture_init(&g, 1);
+		for (int i = 0; i < MS(1000); i++)
+			r |= gesture_sample(&g, 1);
+		for (int i = 0; i < MS(400); i++)
+			r |= gesture_sample(&g, 0);
+		printf("%-26s %s\n", "held at power up", r ? "FAIL, got a gesture" : "(nothing)");
+		if (r)
+			failures++;
+	}
+
+	// Slide switch, PD4 OFF 0x10, PD5 SENSE 0x20, PD6 ON 0x40
+	{
+		static const uint8_t on_to_sense[] = {
+			0x40, 0x40, 0x00, 0x40, 0x00, 0x00, 0x20, 0x00, 0x20, 0x20,
+			0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+		};
+		static const uint8_t wiper_bounce[] = {
+			0x40, 0x00, 0x20, 0x00, 0x20, 0x00, 0x40, 0x00, 0x20, 0x40,
+			0x40, 0x40, 0x40,
+		};
+		static const uint8_t sense_to_off[] = {
+			0x20, 0x00, 0x00, 0x00, 0x10, 0x00, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10,
+		};
+
+		check_switch("switch on to sense", on_to_sense, sizeof(on_to_sense), 0x20, 1);
+		check_switch("switch wiper bounce", wiper_bounce, sizeof(wiper_bounce), 0x40, 0);
+		check_switch("switch sense to off", sense_to_off, sizeof(sense_to_off), 0x10, 1);
+	}
+
+	if (failures)
+		printf("%d case(s) failed\n", failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,238 @@
+/*
+   Golden frame test for the programs
+
+   Runs each program on its own, through the compositor and tlc_commit()
+   into the TLC5947 model, and compares what was latched with a reference
+   capture checked in next to this file (capture.h has the format).  Every
+   program has its own reference at full brightness, at half and at the
+   dimmest master dimmer step, each captured at that level, so a change to
+   the dimmer table or to how the output stage scales shows up too.
+
+   Each program runs for at least one whole cycle of what it draws, so
+   every phase of it is checked, but only every stride'th frame is kept,
+   enough to stay at or under REF_FRAMES a reference.
+
+   golden_test [-n frames] [-d counts] [-w]
+
+     -n  only the first n frames kept of each program (default all of them)
+     -d  how far any one channel may be from the reference, in 12 bit
+         counts (default 0, an exact match)
+     -w  write the references instead
+
+   Each run is done in a child process so every program starts from its
+   power on state; the sun show carries the time of day over from one start
+   to the next.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "hal.h"
+#include "tlc5947.h"
+#include "tlc_model.h"
+#include "capture.h"
+#include "programs.h"
+#include "compose.h"
+#include "blend.h"
+#include "sun.h"
+
+// hal_host.c wants these, nothing here sleeps so they never run
+HAL_ISR(TIMER2_COMPA) {}
+HAL_ISR(ADC) {}
+HAL_ISR(PCINT2) {}
+
+// Most frames kept in a reference
+#define REF_FRAMES 2000
+
+static const struct {
+	uint8_t program;
+	const char *name;
+	uint32_t frames;
+} golden[] = {
+	// A whole day, every keyframe segment of every band
+	{PROG_SUN_SHOW,    "sun_show",    DAY_FRAMES},
+	// The envelope down and back up, 0xFFFF/26 frames each way, which is
+	// also a turn of the hue
+	{PROG_SPACESHIP,   "spaceship",   2*(0xFFFF/26 + 1)},
+	// Each of the three colors warms up, then the white, 4096 frames each,
+	// then both decay in 1024 and the sets swap
+	{PROG_XMAS_BALL,   "xmas_ball",   3*(4096 + 4096 + 1024)},
+	// About two turns of the hue
+	{PROG_COLOR_CYCLE, "color_cycle", 2000},
+};
+
+#define NUM_GOLDEN (sizeof(golden)/sizeof(golden[0]))
+
+// Full brightness, half and the dimmest, as dimmer_levels[] steps
+static const uint8_t dimmer_steps[] = {0, 2, DIMMER_STEPS - 1};
+
+#define NUM_DIMMER_STEPS (sizeof(dimmer_steps)/sizeof(dimmer_steps[0]))
+
+// The reference being compared or written
+static char ref_path[64];
+
+// Frames kept in this run, and the -n limit on them
+static uint32_t frames;
+static uint32_t max_frames = 0;
+static int tolerance = 0;
+static int writing = 0;
+
+static tlc_model_t model;
+
+static void watch (uint8_t port) {
+	tlc_model_port(&model, port);
+}
+
+// Largest difference on any channel over the run
+static int worst;
+
+// Run one program at one dimmer step and compare, or write, its frames.
+// Returns non-zero on failure.
+static int run (uint8_t g, uint8_t step) {
+	scene_t scene = {1, {{golden[g].program, LEDS_ALL, BLEND_REPLACE, 0}}};
+	uint32_t stride = (golden[g].frames + REF_FRAMES - 1) / REF_FRAMES;
+	tlc_frame_t frame, got, ref;
+	capture_t cap;
+	uint32_t ms, ref_ms;
+	uint8_t period;
+	int over = 0;
+
+	frames = (golden[g].frames + stride - 1) / stride;
+	if (max_frames && frames > max_frames)
+		frames = max_frames;
+
+	hal_host_init(0);
+	tlc_model_init(&model);
+	hal_host_watch_port(watch);
+	tlc_init();
+	tlc_set_dimmer(pgm_read_word(&dimmer_levels[step]));
+
+	period = compose_start(&scene);
+
+	if (writing ? capture_create(&cap, ref_path, period * stride) : capture_open(&cap, ref_path))
+		return 1;
+
+	if (!writing && cap.frames < frames) {
+		printf("%s has %u frames, wanted %u; make update to write it again  FAIL\n",
+			ref_path, cap.frames, frames);
+		capture_close(&cap);
+		return 1;
+	}
+
+	worst = 0;
+	for (uint32_t n = 0; n < frames * stride; n++) {
+		compose_frame(&frame);
+		tlc_commit(&frame);
+		if (n % stride)
+			continue;
+		tlc_model_frame(&model, &got);
+		ms = n * period;
+
+		if (writing) {
+			if (capture_write(&cap, ms, &got)) {
+				capture_close(&cap);
+				return 1;
+			}
+			continue;
+		}
+
+		if (capture_read(&cap, &ref_ms, &ref) != 1) {
+			capture_close(&cap);
+			return 1;
+		}
+
+		if (ms != ref_ms) {
+			printf("frame %u at %ums, the reference has it at %ums  FAIL\n", n, ms, ref_ms);
+			capture_close(&cap);
+			return 1;
+		}
+
+		for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++) {
+			int diff = abs(tlc_get(&got, ch) - tlc_get(&ref, ch));
+
+			if (diff > worst)
+				worst = diff;
+			if (diff > tolerance && over++ < 5)
+				printf("  frame %u channel %u: %u, reference %u\n", n, ch,
+					tlc_get(&got, ch), tlc_get(&ref, ch));
+		}
+	}
+
+	if (capture_close(&cap))
+		return 1;
+
+	if (tlc_model_errors(&model)) {
+		tlc_model_report(&model);
+		return 1;
+	}
+	return over != 0;
+}
+
+// Do a run in a child process, with a fresh copy of every static
+static int run_fresh (uint8_t g, uint8_t step) {
+	int status;
+	pid_t pid;
+
+	snprintf(ref_path, sizeof(ref_path), "%s_d%u.tlcf", golden[g].name, step);
+
+	fflush(stdout);
+	if ((pid = fork()) < 0) {
+		perror("fork");
+		return 1;
+	}
+
+	if (pid == 0) {
+		int failed = run(g, step);
+
+		if (!writing)
+			printf("%-20s dimmer %4u: %u frames, worst channel %d off%s\n",
+				ref_path, pgm_read_word(&dimmer_levels[step]), frames, worst,
+				failed ? "  FAIL" : "");
+		else if (!failed)
+			printf("wrote %u frames to %s\n", frames, ref_path);
+		fflush(stdout);
+		_exit(failed);
+	}
+
+	if (waitpid(pid, &status, 0) < 0) {
+		perror("waitpid");
+		return 1;
+	}
+	if (!WIFEXITED(status)) {
+		printf("%s crashed  FAIL\n", ref_path);
+		return 1;
+	}
+	return WEXITSTATUS(status) != 0;
+}
+
+int main (int argc, char **argv) {
+	int failures = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:d:w")) != -1) {
+		switch (opt) {
+		case 'n' :
+			max_frames = strtoul(optarg, NULL, 0);
+			break;
+		case 'd' :
+			tolerance = atoi(optarg);
+			break;
+		case 'w' :
+			writing = 1;
+			break;
+		default :
+			fprintf(stderr, "usage: %s [-n frames] [-d counts] [-w]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (uint8_t g = 0; g < NUM_GOLDEN; g++)
+		for (uint8_t d = 0; d < NUM_DIMMER_STEPS; d++)
+			failures += run_fresh(g, dimmer_steps[d]);
+
+	if (failures)
+		printf("%d run(s) failed\n", failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
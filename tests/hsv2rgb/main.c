@@ -0,0 +1,140 @@
+/*
+   Host test for the fixed point hsv2rgb() in color.c
+
+   Runs hsv2rgb() against the original float implementation two ways:
+
+   - every 16 bit hue, at every 65th saturation and value (64 x 64)
+   - every 12 bit saturation and value pair (4096 x 4096), at six hues in
+     each sector: either side of and on the boundary where it starts, and a
+     quarter, half and three quarters of the way in
+
+   That isn't every input, 2^40 conversions would take hours.  The hues for
+   the full grid are picked because hsv2rgb() only sees the hue as a sector
+   and a 12 bit fraction f of the way through it, and f only ever scales s
+   inside scale12().  So how s and v are handled can only change with f,
+   and the full grid is run with f at both ends of its range and spread
+   across the middle, in every sector.  The first sweep covers every f.
+
+   Fails if any channel is off by more than TOLERANCE counts.  Also prints
+   the host time per call for both; cycle counts on the AVR come from the
+   simulator benchmark (tools/avrbench).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "color.h"
+
+#define TOLERANCE 2
+
+// The original firmware implementation, kept here as the reference
+static void hsv2rgb_float (float h, float s, float v, uint16_t *r, uint16_t *g, uint16_t *b) {
+	float fr = 0;
+	float fg = 0;
+	float fb = 0;
+
+	int i = h * 6;
+	float f = h * 6 - i;
+	float p = v * (1 - s);
+	float q = v * (1 - f * s);
+	float t = v * (1 - (1 - f) * s);
+
+	switch (i%6) {
+		case 0: fr = v; fg = t; fb = p; break;
+		case 1: fr = q; fg = v; fb = p; break;
+		case 2: fr = p; fg = v; fb = t; break;
+		case 3: fr = p; fg = q; fb = v; break;
+		case 4: fr = t; fg = p; fb = v; break;
+		case 5: fr = v; fg = p; fb = q; break;
+	}
+
+	*r = fr*0x0FFF;
+	*g = fg*0x0FFF;
+	*b = fb*0x0FFF;
+}
+
+static unsigned long checked = 0;
+static unsigned long hist[TOLERANCE+2];
+static int worst = 0;
+
+static int diff (uint16_t a, uint16_t b) {
+	return a > b ? a - b : b - a;
+}
+
+static void check (uint16_t h, uint16_t s, uint16_t v) {
+	uint16_t r1, g1, b1, r2, g2, b2;
+	int d;
+
+	hsv2rgb_float(h / (float) HUE_TURN, s / (float) HSV_MAX, v / (float) HSV_MAX, &r1, &g1, &b1);
+	hsv2rgb(h, s, v, &r2, &g2, &b2);
+
+	d = diff(r1, r2);
+	if (diff(g1, g2) > d)
+		d = diff(g1, g2);
+	if (diff(b1, b2) > d)
+		d = diff(b1, b2);
+
+	if (d > worst) {
+		worst = d;
+		if (d > TOLERANCE)
+			printf("h=%04x s=%03x v=%03x float=%03x,%03x,%03x fixed=%03x,%03x,%03x\n",
+				h, s, v, r1, g1, b1, r2, g2, b2);
+	}
+	hist[d > TOLERANCE ? TOLERANCE+1 : d]++;
+	checked++;
+}
+
+static double ns_per_call (int fixed) {
+	struct timespec t0, t1;
+	volatile uint16_t sink;
+	uint16_t r, g, b;
+	uint32_t n;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (n = 0; n < 10000000; n++) {
+		if (fixed)
+			hsv2rgb(n * 7, n & HSV_MAX, (n >> 3) & HSV_MAX, &r, &g, &b);
+		else
+			hsv2rgb_float((uint16_t) (n * 7) / (float) HUE_TURN, (n & HSV_MAX) / (float) HSV_MAX,
+				((n >> 3) & HSV_MAX) / (float) HSV_MAX, &r, &g, &b);
+		sink = r + g + b;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	(void) sink;
+
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / n;
+}
+
+int main (void) {
+	// Where the full saturation and value grid is run within each sector,
+	// in 1/24ths of a turn, and how far either side
+	static const struct {
+		uint8_t at;
+		int8_t d;
+	} hues[] = {{0, -1}, {0, 0}, {0, 1}, {1, 0}, {2, 0}, {3, 0}};
+	uint32_t h, s, v;
+	int sector, i;
+
+	// Every hue
+	for (h = 0; h < HUE_TURN; h++)
+		for (s = 0; s <= HSV_MAX; s += 65)
+			for (v = 0; v <= HSV_MAX; v += 65)
+				check(h, s, v);
+
+	// Every saturation and value, at the hues in hues[] in each sector
+	for (sector = 0; sector < 6; sector++)
+		for (i = 0; i < sizeof(hues)/sizeof(hues[0]); i++)
+			for (s = 0; s <= HSV_MAX; s++)
+				for (v = 0; v <= HSV_MAX; v++)
+					check((uint16_t) ((sector*4 + hues[i].at) * HUE_TURN / 24 + hues[i].d), s, v);
+
+	printf("%lu conversions, worst error %d counts\n", checked, worst);
+	for (i = 0; i <= TOLERANCE; i++)
+		printf("  off by %d: %lu\n", i, hist[i]);
+	printf("  over tolerance: %lu\n", hist[TOLERANCE+1]);
+
+	printf("host time per call: float %.1fns, fixed %.1fns\n", ns_per_call(0), ns_per_call(1));
+
+	return hist[TOLERANCE+1] ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,21 @@
+#ifndef HOST_PGMSPACE_H
+#define HOST_PGMSPACE_H
+
+/*
+   Stand-in for avr-libc's pgmspace.h so the portable parts of the firmware
+   build with the native compiler.  Flash and RAM are the same thing here.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+
+#define pgm_read_byte(p)  (*(const uint8_t *) (p))
+#define pgm_read_word(p)  (*(const uint16_t *) (p))
+#define pgm_read_dword(p) (*(const uint32_t *) (p))
+#define pgm_read_float(p) (*(const float *) (p))
+
+#define memcpy_P memcpy
+
+#endif
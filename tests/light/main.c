@@ -0,0 +1,131 @@
+/*
+   Host test for the sense mode light filter in light.c
+
+   Feeds made up light sensor traces, one 12 bit sample every
+   LIGHT_SAMPLE_MS with pseudo random noise on top, through light_update()
+   and counts how often the lights would switch.  Dusk and dawn must switch
+   exactly once however noisy the sensor is, a level sitting between the two
+   thresholds or a short flash of light must not switch at all, and a clean
+   step must switch after the dwell time and not before.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "light.h"
+
+#define SAMPLES(ms) ((ms) / LIGHT_SAMPLE_MS)
+
+static int failures = 0;
+static uint32_t seed;
+
+// Noise in -amp..amp
+static int noise (int amp) {
+	seed = seed * 1103515245 + 12345;
+	return amp ? (int) ((seed >> 16) % (2*amp + 1)) - amp : 0;
+}
+
+static uint16_t clamp (int v) {
+	return v < 0 ? 0 : v > 4095 ? 4095 : v;
+}
+
+typedef struct {
+	int changes;
+	int first;		// Sample of the first change, -1 for none
+	uint8_t state;
+} result_t;
+
+// Level ramps from a to b over ms, with noise
+static void ramp (light_t *l, result_t *r, int *t, int a, int b, int ms, int amp) {
+	int n = SAMPLES(ms);
+
+	for (int i = 0; i < n; i++, (*t)++) {
+		int level = a + (b - a) * i / n;
+		if (light_update(l, clamp(level + noise(amp)))) {
+			if (r->changes++ == 0)
+				r->first = *t;
+		}
+	}
+	r->state = l->state;
+}
+
+static void report (const char *name, result_t *r, int changes, uint8_t state) {
+	printf("%-24s %d change(s), ", name, r->changes);
+	if (r->first >= 0)
+		printf("first after %dms, ", r->first * LIGHT_SAMPLE_MS);
+	printf("lights %s", r->state == LIGHT_ON ? "on" : "off");
+
+	if (r->changes != changes || r->state != state) {
+		printf("  FAIL, expected %d change(s) and lights %s", changes,
+			state == LIGHT_ON ? "on" : "off");
+		failures++;
+	}
+	printf("\n");
+}
+
+// Start from a settled level, the first sample sets the state and doesn't count
+static void start (light_t *l, result_t *r, int *t, int level) {
+	light_init(l);
+	light_update(l, level);
+	r->changes = 0;
+	r->first = -1;
+	*t = 0;
+}
+
+int main (void) {
+	light_t l;
+	result_t r;
+	int t;
+
+	for (int amp = 0; amp <= 300; amp += 100) {
+		char name[32];
+
+		seed = amp;
+		start(&l, &r, &t, 2000);
+		ramp(&l, &r, &t, 2000, 400, 10*60*1000L, amp);
+		ramp(&l, &r, &t, 400, 400, 60*1000L, amp);
+		sprintf(name, "dusk, noise +-%d", amp);
+		report(name, &r, 1, LIGHT_ON);
+
+		start(&l, &r, &t, 400);
+		ramp(&l, &r, &t, 400, 2000, 10*60*1000L, amp);
+		ramp(&l, &r, &t, 2000, 2000, 60*1000L, amp);
+		sprintf(name, "dawn, noise +-%d", amp);
+		report(name, &r, 1, LIGHT_OFF);
+	}
+
+	// Sitting between the thresholds, from either side
+	seed = 1;
+	start(&l, &r, &t, 900);
+	ramp(&l, &r, &t, 1040, 1040, 30*60*1000L, 200);
+	report("hovering, was dark", &r, 0, LIGHT_ON);
+
+	start(&l, &r, &t, 1200);
+	ramp(&l, &r, &t, 1040, 1040, 30*60*1000L, 200);
+	report("hovering, was bright", &r, 0, LIGHT_OFF);
+
+	// Headlights sweeping past for half a second
+	seed = 2;
+	start(&l, &r, &t, 500);
+	ramp(&l, &r, &t, 500, 500, 10*1000L, 50);
+	ramp(&l, &r, &t, 4000, 4000, 500, 50);
+	ramp(&l, &r, &t, 500, 500, 10*1000L, 50);
+	report("headlights", &r, 0, LIGHT_ON);
+
+	// A light switched on in the room, then off again
+	start(&l, &r, &t, 500);
+	ramp(&l, &r, &t, 3000, 3000, 10*1000L, 0);
+	report("room light on", &r, 1, LIGHT_OFF);
+	if (r.first * LIGHT_SAMPLE_MS < LIGHT_DWELL_MS || r.first * LIGHT_SAMPLE_MS > LIGHT_DWELL_MS + 1000) {
+		printf("  FAIL, should switch between %dms and %dms\n", LIGHT_DWELL_MS, LIGHT_DWELL_MS + 1000);
+		failures++;
+	}
+
+	start(&l, &r, &t, 3000);
+	ramp(&l, &r, &t, 500, 500, 10*1000L, 0);
+	report("room light off", &r, 1, LIGHT_ON);
+
+	if (failures)
+		printf("%d case(s) failed\n", failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/*
+   Host script test: the crossfade in sense mode
+
+   Reads the capture main-host wrote running sense_fade.txt: a program
+   change while sense mode has the lights off because the room is bright,
+   then the room going dark.  The first frame latched after the light drops
+   has to be black, the start of a fade up from the blank frame, and the
+   frames after it have to come up from there.  A fade started while nothing
+   was drawn used to pick up the frame from before the room got bright.
+
+   sense_fade_test capture dark_ms
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tlc5947.h"
+#include "capture.h"
+
+// Frames after the first to check are coming up, 400ms at the xmas ball's 5ms
+#define FADE_FRAMES 80
+
+static uint16_t brightest (const tlc_frame_t *f) {
+	uint16_t max = 0;
+
+	for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++)
+		if (tlc_get(f, ch) > max)
+			max = tlc_get(f, ch);
+	return max;
+}
+
+int main (int argc, char **argv) {
+	capture_t cap;
+	tlc_frame_t f;
+	uint32_t ms, dark_ms;
+	uint16_t max, last = 0;
+	int n = 0, r, failed = 0;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s capture dark_ms\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	dark_ms = strtoul(argv[2], NULL, 0);
+
+	if (capture_open(&cap, argv[1]))
+		return EXIT_FAILURE;
+
+	while ((r = capture_read(&cap, &ms, &f)) == 1 && n <= FADE_FRAMES) {
+		if (ms < dark_ms)
+			continue;
+
+		max = brightest(&f);
+		if (n == 0 && max != 0) {
+			printf("first frame after dark, at %ums, has a channel at %u, not black  FAIL\n",
+				ms, max);
+			failed = 1;
+		} else if (max < last) {
+			printf("frame at %ums went down from %u to %u while fading up  FAIL\n",
+				ms, last, max);
+			failed = 1;
+		}
+		last = max;
+		n++;
+	}
+
+	if (r < 0 || capture_close(&cap))
+		return EXIT_FAILURE;
+
+	if (n <= FADE_FRAMES) {
+		printf("only %d frame(s) after %ums, the lights didn't come back  FAIL\n", n, dark_ms);
+		failed = 1;
+	} else if (!failed) {
+		printf("faded up from black at %ums, up to %u over %d frames\n",
+			dark_ms, last, FADE_FRAMES);
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
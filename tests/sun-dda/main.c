@@ -0,0 +1,173 @@
+/*
+   Host test for the sun show keyframe engine in sun.c
+
+   Runs a whole day, DAY_FRAMES frames, through sun_advance() and compares
+   every band against the original float interpolation that recomputed the
+   position in the hour every frame, using the keyframes from sun_bands.txt
+   as written.  This covers the tables tools/sunc generates as well.  Hue,
+   saturation and value must agree to within one count.  The RGB the fixed
+   point hsv2rgb() makes of them is also compared with the original float
+   hsv2rgb() of the float interpolation, the whole float pipeline the
+   firmware used to run, to within RGB_TOLERANCE.  Also checks that
+   sun_seek() lands on the same values as stepping does.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sun.h"
+#include "color.h"
+
+#define TOLERANCE 1
+
+// The fixed point hsv2rgb() alone is within 2 counts of the float one (see
+// tests/hsv2rgb), on top of the interpolation's one count
+#define RGB_TOLERANCE 3
+
+// The original firmware hsv2rgb(), kept here as the reference
+static void hsv2rgb_float (float h, float s, float v,
+		uint16_t *r, uint16_t *g, uint16_t *b) {
+	float fr = 0;
+	float fg = 0;
+	float fb = 0;
+
+	int i = h * 6;
+	float f = h * 6 - i;
+	float p = v * (1 - s);
+	float q = v * (1 - f * s);
+	float t = v * (1 - (1 - f) * s);
+
+	switch (i%6) {
+		case 0: fr = v; fg = t; fb = p; break;
+		case 1: fr = q; fg = v; fb = p; break;
+		case 2: fr = p; fg = v; fb = t; break;
+		case 3: fr = p; fg = q; fb = v; break;
+		case 4: fr = t; fg = p; fb = v; break;
+		case 5: fr = v; fg = p; fb = q; break;
+	}
+
+	*r = fr*0x0FFF;
+	*g = fg*0x0FFF;
+	*b = fb*0x0FFF;
+}
+
+// The original per-frame float interpolation
+static void sun_float (int day_counter, int band,
+		float *oh, float *os, float *ov) {
+	int start_hour  = day_counter/((float) HOUR_INTERVAL);
+	int start_count = HOUR_INTERVAL*start_hour;
+	int end_hour    = (start_hour+1)%DAY_SEGMENTS;
+	float progress  = (day_counter-start_count)/((float) HOUR_INTERVAL);
+	float h1, h2, s1, s2, v1, v2;
+	float h, s, v;
+
+	h1 = sun_keyframes[band][start_hour][0];
+	h2 = sun_keyframes[band][end_hour][0];
+	s1 = sun_keyframes[band][start_hour][1];
+	s2 = sun_keyframes[band][end_hour][1];
+	v1 = sun_keyframes[band][start_hour][2];
+	v2 = sun_keyframes[band][end_hour][2];
+
+	if ((h2 < h1) && (h2 < 0.16) && (h1 > 0.5)) {
+		h = h1+( ( (h2+1)-h1 )*progress );
+		if (h > 1.0)
+			h -= 1.0;
+	} else if ((h1 < h2) && (h2 > 0.5) && (h1 < 0.16)) {
+		h = h1+( ( h2-(h1+1) )*progress );
+		if (h < 0.0)
+			h += 1.0;
+	} else {
+		h = h1+((h2-h1)*progress);
+	}
+	s = s1+((s2-s1)*progress);
+	v = v1+((v2-v1)*progress);
+
+	*oh = h;
+	*os = s;
+	*ov = v;
+}
+
+static int diff (uint16_t a, uint16_t b) {
+	return a > b ? a - b : b - a;
+}
+
+// Hue is a circle, 0xFFFF and 0x0000 are one count apart
+static int hue_diff (uint16_t a, uint16_t b) {
+	uint16_t d = a - b;
+	return d > 0x8000 ? (uint16_t) -d : d;
+}
+
+static int worst_hsv = 0, worst_rgb = 0, failures = 0;
+
+static void compare (const char *what, int day, int band,
+		uint16_t h, uint16_t s, uint16_t v) {
+	float hf, sf, vf;
+	uint16_t fh, fs, fv;
+	uint16_t r1, g1, b1, r2, g2, b2;
+	int d, e;
+
+	sun_float(day, band, &hf, &sf, &vf);
+	fh = hf * (HUE_TURN-1);
+	fs = sf * HSV_MAX;
+	fv = vf * HSV_MAX;
+
+	d = hue_diff(h, fh);
+	if (diff(s, fs) > d)
+		d = diff(s, fs);
+	if (diff(v, fv) > d)
+		d = diff(v, fv);
+
+	hsv2rgb(h, s, v, &r1, &g1, &b1);
+	hsv2rgb_float(hf, sf, vf, &r2, &g2, &b2);
+	e = diff(r1, r2);
+	if (diff(g1, g2) > e)
+		e = diff(g1, g2);
+	if (diff(b1, b2) > e)
+		e = diff(b1, b2);
+
+	if (d > worst_hsv)
+		worst_hsv = d;
+	if (e > worst_rgb)
+		worst_rgb = e;
+
+	if (d > TOLERANCE || e > RGB_TOLERANCE) {
+		if (failures++ < 10)
+			printf("%s: day %d band %d: hsv %04x,%03x,%03x float %04x,%03x,%03x, rgb off by %d\n",
+				what, day, band, h, s, v, fh, fs, fv, e);
+	}
+}
+
+int main (void) {
+	sun_t sun;
+	uint16_t h, s, v;
+	int day, band, seeks = 0;
+
+	// Two full days, so the wrap at DAY_FRAMES is covered
+	sun_seek(&sun, 0);
+	for (day = 0; day < 2*DAY_FRAMES; day++) {
+		if (sun_day(&sun) != day % DAY_FRAMES) {
+			printf("day counter is %u, expected %d\n", sun_day(&sun), day % DAY_FRAMES);
+			return EXIT_FAILURE;
+		}
+		for (band = 0; band < SUN_BANDS; band++) {
+			sun_band_hsv(&sun, band, &h, &s, &v);
+			compare("step", day % DAY_FRAMES, band, h, s, v);
+		}
+		sun_advance(&sun);
+	}
+
+	// Starting part way through the day
+	for (day = 0; day < DAY_FRAMES; day += 37) {
+		sun_seek(&sun, day);
+		for (band = 0; band < SUN_BANDS; band++) {
+			sun_band_hsv(&sun, band, &h, &s, &v);
+			compare("seek", day, band, h, s, v);
+		}
+		seeks++;
+	}
+
+	printf("%d frames x %d bands stepped, %d seeks\n", 2*DAY_FRAMES, SUN_BANDS, seeks);
+	printf("worst hsv error %d counts, worst rgb error %d counts\n", worst_hsv, worst_rgb);
+
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
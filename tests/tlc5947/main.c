@@ -0,0 +1,150 @@
+/*
+   Host test for the TLC5947 output stage
+
+   Runs the bit-banged tlc_commit() on the host HAL with the port writes
+   going into the TLC5947 model in tlc_model.c, and checks that every frame
+   latches with exactly 288 clocks and comes out on the right channels, at
+   full brightness and dimmed.  Then feeds the model some broken bit streams
+   by hand, including the 25 word frame the original write_data() sent, to
+   make sure it catches them.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hal.h"
+#include "tlc5947.h"
+#include "tlc_model.h"
+
+// hal_host.c wants these, nothing here uses the timers or the ADC
+HAL_ISR(TIMER1_COMPA) {}
+HAL_ISR(TIMER2_COMPA) {}
+HAL_ISR(ADC) {}
+HAL_ISR(PCINT2) {}
+
+static int failures = 0;
+static tlc_model_t model;
+
+static void watch (uint8_t port) {
+	tlc_model_port(&model, port);
+}
+
+static void fail (const char *what) {
+	printf("%s  FAIL\n", what);
+	failures++;
+}
+
+static void check_commits (void) {
+	static const uint16_t dimmers[] = {TLC_DIMMER_MAX, 2896, 0x800, 91, 0};
+	tlc_frame_t f, want;
+	uint32_t seed = 1;
+
+	tlc_model_init(&model);
+	hal_host_watch_port(watch);
+	tlc_init();
+
+	for (unsigned d = 0; d < sizeof(dimmers)/sizeof(dimmers[0]); d++) {
+		tlc_set_dimmer(dimmers[d]);
+
+		for (int n = 0; n < 200; n++) {
+			for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++) {
+				seed = seed * 1103515245 + 12345;
+				tlc_set(&f, ch, (seed >> 16) & 0xFFF);
+				tlc_set(&want, ch, ((uint32_t) tlc_get(&f, ch) * dimmers[d]) >> 12);
+			}
+
+			tlc_commit(&f);
+
+			if (tlc_model_check(&model, &want) != TLC_CHECK_OK) {
+				printf("dimmer %u frame %d: ", dimmers[d], n);
+				fail("latched the wrong channels");
+				break;
+			}
+		}
+	}
+
+	hal_host_watch_port(NULL);
+
+	tlc_model_report(&model);
+	if (model.latches != 1000 || model.edges != 1000 * TLC_MODEL_BITS || tlc_model_errors(&model))
+		fail("expected 1000 clean latches of 288 clocks");
+}
+
+// Clock words 12 bit words into the model, MSB first, then latch
+static void send (tlc_model_t *m, const uint16_t *words, int n) {
+	for (int w = 0; w < n; w++) {
+		for (int bit = 11; bit >= 0; bit--) {
+			uint8_t sin = (words[w] >> bit) & 1 ? TLC_SIN : 0;
+			tlc_model_port(m, sin);
+			tlc_model_port(m, sin | TLC_SCLK);
+		}
+	}
+	tlc_model_port(m, 0);
+	tlc_model_port(m, TLC_XLAT | TLC_BLANK);
+	tlc_model_port(m, 0);
+}
+
+static void check_model (void) {
+	uint16_t words[TLC_CHANNELS + 1];
+	tlc_frame_t want;
+	tlc_model_t m;
+
+	// Channel 23 goes first
+	for (int ch = 0; ch < TLC_CHANNELS; ch++) {
+		tlc_set(&want, ch, 0x100 + ch);
+		words[TLC_CHANNELS - 1 - ch] = 0x100 + ch;
+	}
+
+	tlc_model_init(&m);
+	send(&m, words, TLC_CHANNELS);
+	if (tlc_model_errors(&m) || tlc_model_check(&m, &want) != TLC_CHECK_OK)
+		fail("a good frame was flagged");
+
+	// The old write_data() loop, x from NUM_BITS down to 0, sent 25 words
+	words[TLC_CHANNELS] = 0;
+	tlc_model_init(&m);
+	send(&m, words, TLC_CHANNELS + 1);
+	if (m.overruns != 1 || m.extra_words != 1)
+		fail("25 words weren't flagged as one extra word");
+	// and channel 23's value falls off the end of the register
+	if (tlc_model_check(&m, &want) != TLC_CHECK_VALUE)
+		fail("25 words should lose the first value");
+
+	tlc_model_init(&m);
+	send(&m, words, TLC_CHANNELS - 1);
+	if (m.short_frames != 1)
+		fail("23 words weren't flagged as short");
+
+	// Channel 0 first instead of 23
+	for (int ch = 0; ch < TLC_CHANNELS; ch++)
+		words[ch] = 0x100 + ch;
+	tlc_model_init(&m);
+	send(&m, words, TLC_CHANNELS);
+	if (tlc_model_errors(&m) || tlc_model_check(&m, &want) != TLC_CHECK_ORDER)
+		fail("reversed channels weren't flagged as out of order");
+
+	tlc_model_init(&m);
+	send(&m, words, 0);
+	if (m.empty_latches != 1)
+		fail("a latch with no data wasn't flagged");
+
+	// A clock edge with XLAT up
+	tlc_model_init(&m);
+	tlc_model_port(&m, TLC_XLAT);
+	tlc_model_port(&m, TLC_XLAT | TLC_SCLK);
+	if (m.clocked_in_latch != 1)
+		fail("clocking during XLAT wasn't flagged");
+
+	printf("model caught the broken streams\n");
+}
+
+int main (void) {
+	hal_host_init(0);
+
+	check_commits();
+	check_model();
+
+	if (failures)
+		printf("%d check(s) failed\n", failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include <string.h>
+
+#include "hal.h"
+#include "tlc5947.h"
+
+#if defined(HAL_HOST) && TLC_BACKEND != TLC_BACKEND_BITBANG
+#error "The host build only has the bit-banged backend"
+#endif
+
+// The frame currently being shifted out, with the dimmer applied.  Only the
+// shift code reads it.
+static tlc_frame_t front;
+
+// Set while a frame is still being shifted out in the background
+static volatile uint8_t busy = 0;
+
+static uint16_t dimmer = TLC_DIMMER_MAX;
+
+#if TLC_BACKEND != TLC_BACKEND_BITBANG
+// Where the interrupt handler is in the front buffer
+static const uint8_t *shift_ptr;
+static uint8_t shift_left;
+#endif
+
+static void latch(void);
+
+void tlc_init (void) {
+	hal_port_output(TLC_XLAT | TLC_BLANK);
+
+#if TLC_BACKEND == TLC_BACKEND_BITBANG
+	hal_port_output(TLC_SCLK | TLC_SIN);
+#elif TLC_BACKEND == TLC_BACKEND_USART
+	// Baud rate must be zero while the transmitter is enabled
+	UBRR0 = 0;
+	// XCK as an output makes the USART the master
+	hal_port_output(1 << PD4);
+	// Master SPI mode, SPI mode 0, MSB first
+	UCSR0C = (1 << UMSEL01) | (1 << UMSEL00);
+	UCSR0B = (1 << TXEN0);
+	// F_CPU/16, see tlc5947.h
+	UBRR0 = 7;
+#elif TLC_BACKEND == TLC_BACKEND_SPI
+	// MOSI, SCK and SS as outputs
+	DDRB |= (1 << PB3) | (1 << PB5) | (1 << PB2);
+	// Master, SPI mode 0, MSB first, F_CPU/16
+	SPCR = (1 << SPE) | (1 << MSTR) | (1 << SPR0);
+	SPSR = 0;
+#endif
+}
+
+void tlc_set_dimmer (uint16_t level) {
+	dimmer = level;
+}
+
+uint8_t tlc_busy (void) {
+	return busy;
+}
+
+void tlc_commit (const tlc_frame_t *frame) {
+	// The front buffer is still going out; wait for it
+	while (busy);
+
+	// Copy rather than swap, the programs only redraw the LEDs that change
+	// so the back buffer has to keep its contents
+	if (dimmer >= TLC_DIMMER_MAX) {
+		memcpy(&front, frame, sizeof(front));
+	} else {
+		for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++)
+			tlc_set(&front, ch, ((uint32_t) tlc_get(frame, ch) * dimmer) >> 12);
+	}
+	busy = 1;
+
+#if TLC_BACKEND == TLC_BACKEND_BITBANG
+	uint8_t x;
+	uint8_t mask;
+	uint8_t val;
+
+	// Start the clock at zero
+	hal_port_write(0);
+
+	for (x = 0; x < TLC_FRAME_BYTES; x++) {
+		val = front.b[x];
+		for (mask = 0x80; mask > 0; mask = mask >> 1) {
+			if (val & mask) {
+				hal_port_write(TLC_SIN);
+			} else {
+				hal_port_write(0x00);
+			}
+			// Pulse the clock to get a rise then fall
+			hal_port_set(TLC_SCLK);
+			hal_port_clear(TLC_SCLK);
+		}
+	}
+
+	latch();
+#else
+	shift_ptr  = front.b;
+	shift_left = TLC_FRAME_BYTES;
+
+#if TLC_BACKEND == TLC_BACKEND_USART
+	// Let the data register empty interrupt feed the bytes
+	UCSR0B |= (1 << UDRIE0);
+#else
+	// Send the first byte, the transfer complete interrupt sends the rest
+	shift_left--;
+	SPDR = *shift_ptr++;
+	SPCR |= (1 << SPIE);
+#endif
+#endif
+}
+
+// Pulse the XLAT & BLANK line to latch in the data and reset the GSCLK
+static void latch (void) {
+	hal_port_set(TLC_XLAT|TLC_BLANK);
+	hal_port_clear(TLC_XLAT|TLC_BLANK);
+	busy = 0;
+}
+
+#if TLC_BACKEND == TLC_BACKEND_USART
+
+HAL_ISR(USART_UDRE) {
+	UDR0 = *shift_ptr++;
+
+	// Last byte is in; latch once it has left the shift register.  TXC0 may
+	// already be set from a gap between bytes, so clear it first.
+	if (--shift_left == 0) {
+		UCSR0A |= (1 << TXC0);
+		UCSR0B = (UCSR0B & ~(1 << UDRIE0)) | (1 << TXCIE0);
+	}
+}
+
+HAL_ISR(USART_TX) {
+	UCSR0B &= ~(1 << TXCIE0);
+	latch();
+}
+
+#elif TLC_BACKEND == TLC_BACKEND_SPI
+
+HAL_ISR(SPI_STC) {
+	if (shift_left) {
+		shift_left--;
+		SPDR = *shift_ptr++;
+	} else {
+		SPCR &= ~(1 << SPIE);
+		latch();
+	}
+}
+
+#endif
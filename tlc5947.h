@@ -0,0 +1,141 @@
+#ifndef TLC5947_H
+#define TLC5947_H
+
+#include <stdint.h>
+
+#include "hal.h"
+
+/*
+   TLC5947 output engine
+
+   The TLC5947 takes a 288 bit stream (24 channels x 12 bits), MSB first,
+   starting with channel 23 and ending with channel 0.  A pulse on XLAT
+   latches the shift register into the PWM outputs, and BLANK resets the
+   grayscale counter.
+
+   Pick the backend at build time with TLC_BACKEND (see the Makefile):
+
+   TLC_BACKEND_BITBANG - SCLK on PD0, SIN on PD1.  The original wiring; every
+                         bit is clocked by hand.
+   TLC_BACKEND_USART   - USART0 in master SPI mode.  SIN on TXD (PD1) as
+                         before, but SCLK must move to XCK (PD4).  PD4 is
+                         the slide switch's OFF input, and XCK drives it as
+                         an output, so the switch's OFF contact has to be
+                         disconnected from PD4 or it holds the clock line
+                         high against the USART.  OFF is then read as
+                         neither SENSE nor ON (see SWITCH_PINS in input.h).
+   TLC_BACKEND_SPI     - SPI peripheral.  SIN on MOSI (PB3), SCLK on SCK (PB5).
+                         PB2 (SS) is driven as an output to stay in master mode.
+
+   XLAT (PD2) and BLANK (PD3) are the same for every backend.  Both hardware
+   backends clock at F_CPU/16.
+
+   Frames are double buffered.  Programs draw into their own buffer and hand
+   it to tlc_commit(), which copies it into the front buffer.  The hardware
+   backends then shift the front buffer out from the USART/SPI interrupt and
+   latch it when the last bit is gone, so the next frame can be drawn while
+   this one is on the wire.  tlc_busy() says whether it's still going out;
+   tlc_commit() waits for it before touching the front buffer.  The
+   bit-banged backend shifts before returning.
+
+   The clock is slow on purpose.  At F_CPU/2 a byte is gone in 16 cycles,
+   less than the ~50 the interrupt handler takes to get in and out, so the
+   CPU would sit in the handler for the whole shift.  At F_CPU/16 a byte
+   takes 128 cycles and the main loop keeps about 60% of the CPU while a
+   frame goes out.
+
+   The master dimmer is applied as the frame is copied into the front buffer,
+   every channel scaled by tlc_set_dimmer()'s level over TLC_DIMMER_MAX.  At
+   full brightness it's a plain copy.
+
+   Estimated cost of one frame at 8MHz (-Os), counted from the generated
+   instruction sequences rather than measured:
+
+     backend    CPU      on the wire
+     bitbang    ~5300    ~660us   (~18 cycles per bit, 288 bits, all CPU)
+     usart      ~2000    ~580us   (~50 cycles of interrupt per byte, UDR0
+                                   is double buffered so there's no gap)
+     spi        ~2000    ~680us   (the same, plus the interrupt latency
+                                   between bytes)
+
+   On top of that the copy into the front buffer takes ~250 cycles.
+*/
+
+#define TLC_BACKEND_BITBANG 0
+#define TLC_BACKEND_USART   1
+#define TLC_BACKEND_SPI     2
+
+#ifndef TLC_BACKEND
+#define TLC_BACKEND TLC_BACKEND_BITBANG
+#endif
+
+#define TLC_CHANNELS 24
+#define TLC_FRAME_BYTES (TLC_CHANNELS*12/8)
+
+// Master dimmer level for full brightness
+#define TLC_DIMMER_MAX 0x1000
+
+/*
+   A frame is kept packed in the order it goes out on the wire: 12 bits per
+   channel, MSB first, channel 23 first.  Each pair of channels shares three
+   bytes, e.g. channels 23 and 22 are
+
+	b[0] = ch23[11:4]
+	b[1] = ch23[3:0] ch22[11:8]
+	b[2] = ch22[7:0]
+
+   so the shift stage just streams the bytes.
+*/
+typedef struct {
+	uint8_t b[TLC_FRAME_BYTES];
+} tlc_frame_t;
+
+// Control lines on port D
+#define TLC_SCLK  (1 << PD0)
+#define TLC_SIN   (1 << PD1)
+#define TLC_XLAT  (1 << PD2)
+#define TLC_BLANK (1 << PD3)
+
+// Offset of the three bytes holding channel ch and its pair
+#define TLC_PAIR_OFFSET(ch) (TLC_FRAME_BYTES - 3 - ((ch) >> 1)*3)
+
+static inline void tlc_set (tlc_frame_t *f, uint8_t ch, uint16_t val) {
+	uint8_t *p = &f->b[TLC_PAIR_OFFSET(ch)];
+
+	if (ch & 1) {
+		p[0] = val >> 4;
+		p[1] = (p[1] & 0x0F) | (val << 4);
+	} else {
+		p[1] = (p[1] & 0xF0) | ((val >> 8) & 0x0F);
+		p[2] = val;
+	}
+}
+
+static inline uint16_t tlc_get (const tlc_frame_t *f, uint8_t ch) {
+	const uint8_t *p = &f->b[TLC_PAIR_OFFSET(ch)];
+
+	if (ch & 1)
+		return ((uint16_t) p[0] << 4) | (p[1] >> 4);
+	else
+		return ((uint16_t) (p[1] & 0x0F) << 8) | p[2];
+}
+
+// LEDs are wired Blue, Red, Green, starting at channel idx
+static inline void tlc_set_rgb (tlc_frame_t *f, uint8_t idx, uint16_t r, uint16_t g, uint16_t b) {
+	tlc_set(f, idx, b);
+	tlc_set(f, idx+1, r);
+	tlc_set(f, idx+2, g);
+}
+
+static inline void tlc_set_led (tlc_frame_t *f, uint8_t led, uint16_t r, uint16_t g, uint16_t b) {
+	tlc_set_rgb(f, led*3, r, g, b);
+}
+
+void tlc_init(void);
+void tlc_commit(const tlc_frame_t *frame);
+
+// 0 - TLC_DIMMER_MAX, from the next commit on
+void tlc_set_dimmer(uint16_t level);
+uint8_t tlc_busy(void);
+
+#endif
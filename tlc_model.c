@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tlc_model.h"
+
+void tlc_model_init (tlc_model_t *m) {
+	memset(m, 0, sizeof(*m));
+}
+
+static void clock_in (tlc_model_t *m, uint8_t bit) {
+	// Channel 23's MSB falls off the end
+	for (uint8_t ch = TLC_CHANNELS - 1; ch > 0; ch--)
+		m->shift[ch] = ((m->shift[ch] << 1) | (m->shift[ch-1] >> 11)) & 0xFFF;
+	m->shift[0] = ((m->shift[0] << 1) | bit) & 0xFFF;
+
+	m->clocks++;
+	m->edges++;
+}
+
+static void latch (tlc_model_t *m) {
+	if (m->clocks == 0) {
+		m->empty_latches++;
+	} else if (m->clocks < TLC_MODEL_BITS) {
+		m->short_frames++;
+	} else if (m->clocks > TLC_MODEL_BITS) {
+		m->overruns++;
+		if ((m->clocks - TLC_MODEL_BITS) % 12 == 0)
+			m->extra_words += (m->clocks - TLC_MODEL_BITS) / 12;
+	}
+
+	memcpy(m->out, m->shift, sizeof(m->out));
+	m->clocks = 0;
+	m->latches++;
+}
+
+void tlc_model_port (tlc_model_t *m, uint8_t port) {
+	uint8_t rose = port & ~m->port;
+
+	if (rose & TLC_SCLK) {
+		if (port & TLC_XLAT)
+			m->clocked_in_latch++;
+		clock_in(m, (port & TLC_SIN) != 0);
+	}
+
+	if (rose & TLC_XLAT)
+		latch(m);
+
+	m->port = port;
+}
+
+uint32_t tlc_model_errors (const tlc_model_t *m) {
+	return m->short_frames + m->overruns + m->empty_latches + m->clocked_in_latch;
+}
+
+uint8_t tlc_model_check (const tlc_model_t *m, const tlc_frame_t *expect) {
+	uint8_t used[TLC_CHANNELS] = {0};
+	uint8_t ch, n, wrong = 0;
+
+	for (ch = 0; ch < TLC_CHANNELS; ch++) {
+		if (m->out[ch] != tlc_get(expect, ch))
+			wrong = 1;
+	}
+	if (!wrong)
+		return TLC_CHECK_OK;
+
+	// Every value is there, just not where it should be
+	for (ch = 0; ch < TLC_CHANNELS; ch++) {
+		for (n = 0; n < TLC_CHANNELS; n++) {
+			if (!used[n] && m->out[n] == tlc_get(expect, ch)) {
+				used[n] = 1;
+				break;
+			}
+		}
+		if (n == TLC_CHANNELS)
+			return TLC_CHECK_VALUE;
+	}
+	return TLC_CHECK_ORDER;
+}
+
+void tlc_model_frame (const tlc_model_t *m, tlc_frame_t *f) {
+	for (uint8_t ch = 0; ch < TLC_CHANNELS; ch++)
+		tlc_set(f, ch, m->out[ch]);
+}
+
+void tlc_model_report (const tlc_model_t *m) {
+	printf("TLC5947: %u latches, %u clock edges", m->latches, m->edges);
+	if (m->short_frames)
+		printf(", %u short", m->short_frames);
+	if (m->overruns)
+		printf(", %u overrun (%u extra words)", m->overruns, m->extra_words);
+	if (m->empty_latches)
+		printf(", %u empty", m->empty_latches);
+	if (m->clocked_in_latch)
+		printf(", %u clocked during XLAT", m->clocked_in_latch);
+	printf("\n");
+}
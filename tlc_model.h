@@ -0,0 +1,69 @@
+#ifndef TLC_MODEL_H
+#define TLC_MODEL_H
+
+#include <stdint.h>
+
+#include "tlc5947.h"
+
+/*
+   Host model of the TLC5947 input side
+
+   Fed every value written to port D (hal_host_watch_port()), it does what
+   the chip does with SCLK, SIN, XLAT and BLANK: SIN is clocked into a 288
+   bit shift register on each rising SCLK edge and the register is copied
+   to the 24 channel outputs on a rising XLAT edge.  Bits shifted past the
+   end of the register are lost, as they would be off SOUT with one chip.
+
+   Along the way it counts what would be wrong on the real thing:
+
+     short      latched after fewer than 288 clocks, the frame is shifted
+                by the missing bits
+     overrun    more than 288 clocks before the latch, so the first bits
+                fell off the end.  A whole number of extra 12 bit words is
+                also counted in extra_words.
+     empty      latched with no clocks since the last latch
+     clocked    SCLK rose while XLAT was high
+
+   tlc_model_check() compares the latched channels with the frame that was
+   meant to go out, and tells a channel order mistake (the right values on
+   the wrong channels) from wrong values.
+*/
+
+#define TLC_MODEL_BITS (TLC_CHANNELS * 12)
+
+typedef struct {
+	uint8_t port;			// Last value seen
+	uint16_t shift[TLC_CHANNELS];	// Shift register, channel 0 nearest SIN
+	uint16_t clocks;		// Rising SCLK edges since the last latch
+	uint16_t out[TLC_CHANNELS];	// What was latched
+
+	uint32_t latches;
+	uint32_t edges;			// Rising SCLK edges in all
+	uint32_t short_frames;
+	uint32_t overruns;
+	uint32_t extra_words;
+	uint32_t empty_latches;
+	uint32_t clocked_in_latch;
+} tlc_model_t;
+
+#define TLC_CHECK_OK    0
+#define TLC_CHECK_ORDER 1	// Right values, wrong channels
+#define TLC_CHECK_VALUE 2	// Wrong values
+
+void tlc_model_init(tlc_model_t *m);
+
+// A new value on port D
+void tlc_model_port(tlc_model_t *m, uint8_t port);
+
+// Problems with the bit stream so far
+uint32_t tlc_model_errors(const tlc_model_t *m);
+
+// Compare the latched channels with the frame that should be there
+uint8_t tlc_model_check(const tlc_model_t *m, const tlc_frame_t *expect);
+
+// The latched channels, packed as a frame
+void tlc_model_frame(const tlc_model_t *m, tlc_frame_t *f);
+
+void tlc_model_report(const tlc_model_t *m);
+
+#endif
@@ -0,0 +1,439 @@
+/*
+   avrbench - frame cost benchmark under simavr
+
+   Runs main.elf, built with `make BENCH=1`, on a simulated ATmega168 with
+   the slide switch on, and counts the CPU cycles between the bench.h
+   markers: each program's step(), hsv2rgb(), write_data() and the whole
+   frame.  It lets every scene settle for a while, measures it, then gives
+   the button a short press for the next one, until it's back at the first.
+   Then long presses take the master dimmer down to the next step asked
+   for and it goes round the scenes again.
+
+   usage: avrbench [-m mcu] [-f hz] [-w ms] [-t ms] [-d steps] [-o report.json] main.elf
+
+     -m  simavr's name for the chip (default atmega168)
+     -f  clock (default 8000000)
+     -w  time to let each scene settle before measuring (default 2000)
+     -t  time to measure each scene for (default 10000)
+     -d  dimmer_levels[] steps to measure at, comma separated and in
+         increasing order (default 0,2: full and half brightness, the two
+         levels the original eight programs ran at)
+     -o  where the JSON report goes (default stdout)
+
+   The report has an entry per program and dimmer step, keyed by the
+   program's index in programs[].  step() and the hsv2rgb() calls made from
+   it are charged to the program whichever scene it ran in.  The whole
+   frame and write_data() are only charged to a program from scenes where
+   it ran alone; a scene with several layers can't split them.  Every scene
+   is also reported as measured.
+
+   Counts are cycles.  Interrupts that land inside a measured stretch are
+   counted in, which is what the frame pays for them too.  With the USART
+   and SPI backends write_data() only covers handing the frame over; the
+   shifting happens in interrupts afterwards, and is counted in wherever
+   they land.
+
+   Built on the host by `make bench`, which needs simavr installed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "avrsim.h"
+#include "../bench.h"
+
+#define BUTTON_PIN 7
+#define SWITCH_OFF_PIN 4
+#define SWITCH_SENSE_PIN 5
+#define SWITCH_ON_PIN 6
+
+// Button timing, short and long presses by debounce.h's rules
+#define PRESS_MS 100
+#define LONG_MS 800
+#define SCENE_WAIT_MS 1500
+
+#define MAX_RESULTS (BENCH_SCENES * 4)
+
+typedef struct {
+	uint32_t count;
+	uint64_t sum;
+	uint32_t min, max;
+} stat_t;
+
+typedef struct {
+	stat_t step;
+	stat_t hsv;		// Each call made from step()
+	stat_t hsv_step;	// All the calls in one step()
+	stat_t hsv_calls;	// Calls per step()
+} prog_stats_t;
+
+typedef struct {
+	uint8_t scene;
+	uint8_t dim_step;
+	stat_t frame;
+	stat_t write;
+	stat_t hsv;		// Each call
+	stat_t hsv_frame;	// All the calls in a frame
+	stat_t hsv_calls;	// Calls per frame
+	prog_stats_t prog[BENCH_STEPS];
+} scene_stats_t;
+
+static scene_stats_t results[MAX_RESULTS];
+static int num_results = 0;
+static scene_stats_t *cur = NULL;	// Being measured, NULL while settling
+
+// Where each region began, 0 if it hasn't since measuring started
+static avr_cycle_count_t begun[0x80];
+
+// hsv2rgb() within the current frame
+static uint64_t frame_hsv;
+static uint32_t frame_hsv_calls;
+
+// The program whose step() we're in, -1 outside, and its hsv2rgb() so far
+static int stepping = -1;
+static uint64_t step_hsv;
+static uint32_t step_hsv_calls;
+
+static uint8_t scene_started;
+static uint8_t scene;
+static uint8_t dimmer_marked;
+static uint8_t dim_step;
+
+static void stat_add (stat_t *s, uint64_t v) {
+	if (s->count == 0 || v < s->min)
+		s->min = v;
+	if (v > s->max)
+		s->max = v;
+	s->sum += v;
+	s->count++;
+}
+
+static void stat_merge (stat_t *s, const stat_t *from) {
+	if (!from->count)
+		return;
+	if (s->count == 0 || from->min < s->min)
+		s->min = from->min;
+	if (from->max > s->max)
+		s->max = from->max;
+	s->sum += from->sum;
+	s->count += from->count;
+}
+
+static void mark (uint8_t id, avr_cycle_count_t cycle) {
+	uint8_t region = id & ~BENCH_END_FLAG;
+	uint64_t cycles;
+
+	if (region >= BENCH_SCENE(0) && region < BENCH_SCENE(BENCH_SCENES)) {
+		scene = region - BENCH_SCENE(0);
+		scene_started = 1;
+		return;
+	}
+	if (region >= BENCH_DIMMER(0) && region < BENCH_DIMMER(BENCH_DIMMERS)) {
+		dim_step = region - BENCH_DIMMER(0);
+		dimmer_marked = 1;
+		return;
+	}
+
+	if (!cur)
+		return;
+
+	if (!(id & BENCH_END_FLAG)) {
+		begun[region] = cycle;
+		if (region == BENCH_FRAME) {
+			frame_hsv = 0;
+			frame_hsv_calls = 0;
+		} else if (region >= BENCH_STEP(0) && region < BENCH_STEP(BENCH_STEPS)) {
+			stepping = region - BENCH_STEP(0);
+			step_hsv = 0;
+			step_hsv_calls = 0;
+		}
+		return;
+	}
+
+	// An end without its begin, measuring started in the middle
+	if (!begun[region])
+		return;
+	cycles = cycle - begun[region];
+	begun[region] = 0;
+
+	if (region == BENCH_FRAME) {
+		stat_add(&cur->frame, cycles);
+		stat_add(&cur->hsv_frame, frame_hsv);
+		stat_add(&cur->hsv_calls, frame_hsv_calls);
+	} else if (region == BENCH_WRITE) {
+		stat_add(&cur->write, cycles);
+	} else if (region == BENCH_HSV2RGB) {
+		stat_add(&cur->hsv, cycles);
+		frame_hsv += cycles;
+		frame_hsv_calls++;
+		if (stepping >= 0) {
+			stat_add(&cur->prog[stepping].hsv, cycles);
+			step_hsv += cycles;
+			step_hsv_calls++;
+		}
+	} else if (region >= BENCH_STEP(0) && region < BENCH_STEP(BENCH_STEPS)) {
+		prog_stats_t *p = &cur->prog[region - BENCH_STEP(0)];
+
+		stat_add(&p->step, cycles);
+		stat_add(&p->hsv_step, step_hsv);
+		stat_add(&p->hsv_calls, step_hsv_calls);
+		stepping = -1;
+	}
+}
+
+static void print_stat (FILE *f, const char *name, const stat_t *s, const char *after) {
+	fprintf(f, "\"%s\": {\"count\": %u, \"mean\": %.1f, \"min\": %u, \"max\": %u}%s",
+		name, s->count, s->count ? (double) s->sum / s->count : 0.0,
+		s->min, s->max, after);
+}
+
+// The only program that stepped in a measured scene, or -1
+static int solo_program (const scene_stats_t *r) {
+	int solo = -1;
+
+	for (int p = 0; p < BENCH_STEPS; p++) {
+		if (!r->prog[p].step.count)
+			continue;
+		if (solo >= 0)
+			return -1;
+		solo = p;
+	}
+	return solo;
+}
+
+// Everything measured of program p at dimmer step d, over all the scenes
+static void report_program (FILE *f, int p, int d, int *first) {
+	prog_stats_t ps;
+	stat_t frame, write;
+
+	memset(&ps, 0, sizeof(ps));
+	memset(&frame, 0, sizeof(frame));
+	memset(&write, 0, sizeof(write));
+
+	for (int n = 0; n < num_results; n++) {
+		const scene_stats_t *r = &results[n];
+
+		if (r->dim_step != d || !r->prog[p].step.count)
+			continue;
+		stat_merge(&ps.step, &r->prog[p].step);
+		stat_merge(&ps.hsv, &r->prog[p].hsv);
+		stat_merge(&ps.hsv_step, &r->prog[p].hsv_step);
+		stat_merge(&ps.hsv_calls, &r->prog[p].hsv_calls);
+		if (solo_program(r) == p) {
+			stat_merge(&frame, &r->frame);
+			stat_merge(&write, &r->write);
+		}
+	}
+	if (!ps.step.count)
+		return;
+
+	fprintf(f, "%s    {\n      \"program\": %d,\n      \"dimmer_step\": %d,\n      ",
+		*first ? "" : ",\n", p, d);
+	print_stat(f, "step", &ps.step, ",\n      ");
+	print_stat(f, "hsv2rgb", &ps.hsv, ",\n      ");
+	print_stat(f, "hsv2rgb_per_step", &ps.hsv_step, ",\n      ");
+	print_stat(f, "hsv2rgb_calls_per_step", &ps.hsv_calls, frame.count ? ",\n      " : "\n");
+	if (frame.count) {
+		print_stat(f, "frame", &frame, ",\n      ");
+		print_stat(f, "write_data", &write, "\n");
+	}
+	fprintf(f, "    }");
+	*first = 0;
+}
+
+static void report (FILE *f, const char *elf, uint32_t freq, uint32_t settle_ms, uint32_t measure_ms) {
+	int first = 1;
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"elf\": \"%s\",\n", elf);
+	fprintf(f, "  \"f_cpu\": %u,\n", freq);
+	fprintf(f, "  \"settle_ms\": %u,\n", settle_ms);
+	fprintf(f, "  \"measure_ms\": %u,\n", measure_ms);
+	fprintf(f, "  \"units\": \"cycles\",\n");
+
+	fprintf(f, "  \"programs\": [\n");
+	for (int d = 0; d < BENCH_DIMMERS; d++)
+		for (int p = 0; p < BENCH_STEPS; p++)
+			report_program(f, p, d, &first);
+	fprintf(f, "\n  ],\n");
+
+	fprintf(f, "  \"scenes\": [\n");
+	for (int n = 0; n < num_results; n++) {
+		scene_stats_t *r = &results[n];
+
+		first = 1;
+		fprintf(f, "    {\n      \"scene\": %u,\n      \"dimmer_step\": %u,\n      ",
+			r->scene, r->dim_step);
+		print_stat(f, "frame", &r->frame, ",\n      ");
+		print_stat(f, "write_data", &r->write, ",\n      ");
+		print_stat(f, "hsv2rgb", &r->hsv, ",\n      ");
+		print_stat(f, "hsv2rgb_per_frame", &r->hsv_frame, ",\n      ");
+		print_stat(f, "hsv2rgb_calls_per_frame", &r->hsv_calls, ",\n");
+		fprintf(f, "      \"programs\": {");
+
+		for (int p = 0; p < BENCH_STEPS; p++) {
+			char name[8];
+
+			if (!r->prog[p].step.count)
+				continue;
+			snprintf(name, sizeof(name), "%d", p);
+			fprintf(f, "%s\n        ", first ? "" : ",");
+			print_stat(f, name, &r->prog[p].step, "");
+			first = 0;
+		}
+		fprintf(f, "\n      }\n    }%s\n", n + 1 < num_results ? "," : "");
+	}
+
+	fprintf(f, "  ]\n}\n");
+}
+
+static int press (uint32_t ms) {
+	avrsim_input(BUTTON_PIN, 1);
+	if (avrsim_run(avrsim_now() + avrsim_ms(ms), NULL) < 0)
+		return -1;
+	avrsim_input(BUTTON_PIN, 0);
+	return 0;
+}
+
+// Measure every scene once at the current dimmer step, back to the first
+static int measure_scenes (uint32_t settle_ms, uint32_t measure_ms) {
+	uint8_t first_scene = scene;
+
+	do {
+		if (num_results == MAX_RESULTS) {
+			fprintf(stderr, "too many scenes and dimmer steps\n");
+			return -1;
+		}
+		if (avrsim_run(avrsim_now() + avrsim_ms(settle_ms), NULL) < 0)
+			return -1;
+
+		cur = &results[num_results++];
+		cur->scene = scene;
+		cur->dim_step = dim_step;
+		memset(begun, 0, sizeof(begun));
+		stepping = -1;
+		if (avrsim_run(avrsim_now() + avrsim_ms(measure_ms), NULL) < 0)
+			return -1;
+		cur = NULL;
+
+		fprintf(stderr, "scene %u dimmer step %u: %u frames\n", results[num_results-1].scene,
+			dim_step, results[num_results-1].frame.count);
+
+		// On to the next scene
+		scene_started = 0;
+		if (press(PRESS_MS))
+			return -1;
+		if (avrsim_run(avrsim_now() + avrsim_ms(SCENE_WAIT_MS), &scene_started) != 1) {
+			fprintf(stderr, "the button didn't change the scene\n");
+			return -1;
+		}
+	} while (scene != first_scene);
+
+	return 0;
+}
+
+// Long presses until the dimmer is at step d.  They only go down until the
+// dimmest step, where they turn round.
+static int dim_to (uint8_t d) {
+	while (dim_step < d) {
+		uint8_t was = dim_step;
+
+		dimmer_marked = 0;
+		if (press(LONG_MS))
+			return -1;
+		if (!dimmer_marked && avrsim_run(avrsim_now() + avrsim_ms(SCENE_WAIT_MS), &dimmer_marked) != 1) {
+			fprintf(stderr, "the long press didn't change the dimmer\n");
+			return -1;
+		}
+		if (dim_step < was) {
+			fprintf(stderr, "there is no dimmer step %u\n", d);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void usage (const char *name) {
+	fprintf(stderr, "usage: %s [-m mcu] [-f hz] [-w ms] [-t ms] [-d steps] [-o report.json] main.elf\n", name);
+	exit(EXIT_FAILURE);
+}
+
+int main (int argc, char **argv) {
+	const char *mcu = "atmega168";
+	const char *out = NULL;
+	const char *steps = "0,2";
+	uint32_t freq = 8000000;
+	uint32_t settle_ms = 2000;
+	uint32_t measure_ms = 10000;
+	FILE *f = stdout;
+	char *p;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:f:w:t:d:o:")) != -1) {
+		switch (opt) {
+		case 'm' :
+			mcu = optarg;
+			break;
+		case 'f' :
+			freq = strtoul(optarg, NULL, 0);
+			break;
+		case 'w' :
+			settle_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 't' :
+			measure_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'd' :
+			steps = optarg;
+			break;
+		case 'o' :
+			out = optarg;
+			break;
+		default :
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1)
+		usage(argv[0]);
+
+	if (avrsim_load(argv[optind], mcu, freq))
+		return EXIT_FAILURE;
+	avrsim_on_mark(mark);
+
+	// Switch on, button up
+	avrsim_input(SWITCH_OFF_PIN, 0);
+	avrsim_input(SWITCH_SENSE_PIN, 0);
+	avrsim_input(SWITCH_ON_PIN, 1);
+	avrsim_input(BUTTON_PIN, 0);
+
+	if (avrsim_run(avrsim_ms(SCENE_WAIT_MS), &scene_started) != 1) {
+		fprintf(stderr, "%s: no scene started, was it built with BENCH=1?\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	// The firmware starts at full brightness, step 0
+	for (p = (char *) steps; *p; ) {
+		unsigned long d = strtoul(p, &p, 10);
+
+		if ((*p && *p != ',') || d >= BENCH_DIMMERS || d < dim_step)
+			usage(argv[0]);
+		if (*p)
+			p++;
+
+		if (dim_to(d) || measure_scenes(settle_ms, measure_ms))
+			return EXIT_FAILURE;
+	}
+
+	if (out && !(f = fopen(out, "w"))) {
+		perror(out);
+		return EXIT_FAILURE;
+	}
+	report(f, argv[optind], freq, settle_ms, measure_ms);
+	if (f != stdout)
+		fclose(f);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,370 @@
+/*
+   avrlatency - input latency and jitter under simavr
+
+   Runs main.elf, built with `make BENCH=1`, on a simulated ATmega168 and
+   works the button and slide switch at random moments in every scene.  For
+   each input it measures from the edge that makes it to the first frame
+   latched (XLAT rising) that shows the result:
+
+     short        from the release to the first frame of the next scene
+     double       from the second press to the first frame of the scene
+                  before, which takes it back to where it was
+     long         from the press to the first frame at the new dimmer step
+     switch_off   from the switch leaving ON to the blank frame
+     switch_on    from the switch reaching ON, out of power down, to the
+                  first frame drawn
+     sense        from ON to SENSE, to the blank frame sense mode starts with
+     sense_to_on  from SENSE back to ON, to the first frame drawn
+
+   The frame "shows the result" once the main loop has taken the input's
+   event off the queue (the BENCH_EVENT marker); for switch_on and
+   sense_to_on it also has to be a frame that was drawn rather than the
+   blank one written on the way.  Part of every figure is by design: the
+   switch debounce (~20ms), the double press window a short press has to
+   wait out (300ms) and the hold that makes a long press (600ms).  The rest,
+   and how much it varies, is what this is for.
+
+   usage: avrlatency [-m mcu] [-f hz] [-n trials] [-r seed] [-o report.json] main.elf
+
+     -m  simavr's name for the chip (default atmega168)
+     -f  clock (default 8000000)
+     -n  trials of each input in each scene (default 20)
+     -r  seed for the random waits between them (default 1)
+     -o  where the JSON report goes (default stdout)
+
+   Each trial waits a random 200-700ms first so the edges land anywhere in
+   the frame.  The report has min, mean, 50th, 90th and 99th percentile and
+   max in ms, and the spread (max - min), per input per scene and over all
+   scenes.
+
+   Built on the host by `make latency`, which needs simavr installed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "avrsim.h"
+#include "../bench.h"
+#include "../events.h"
+
+#define SWITCH_OFF_PIN 4
+#define SWITCH_SENSE_PIN 5
+#define SWITCH_ON_PIN 6
+#define BUTTON_PIN 7
+#define XLAT_PIN 2
+
+#define CLICK_MS 80		// A quick press
+#define DOUBLE_GAP_MS 120	// Between the two presses of a double
+#define LONG_MS 800		// Held for a long press
+#define WAIT_MIN_MS 200
+#define WAIT_MAX_MS 700
+#define TIMEOUT_MS 3000
+
+enum {
+	IN_SHORT, IN_DOUBLE, IN_LONG, IN_OFF, IN_ON, IN_SENSE, IN_SENSE_TO_ON,
+	NUM_INPUTS
+};
+
+static const char *input_names[NUM_INPUTS] = {
+	"short", "double", "long", "switch_off", "switch_on", "sense", "sense_to_on",
+};
+
+#define MAX_SCENES BENCH_SCENES
+
+// Latencies in cycles, per scene and input
+static avr_cycle_count_t *samples[MAX_SCENES][NUM_INPUTS];
+static int num_samples[MAX_SCENES][NUM_INPUTS];
+static uint8_t scene_order[MAX_SCENES];
+static int num_scenes = 0;
+static int trials = 20;
+
+// The trial in progress
+static struct {
+	uint8_t armed;
+	uint8_t event;		// EV_* to wait for
+	uint8_t drawn;		// Has to be a drawn frame
+	uint8_t seen_event;
+	uint8_t seen_frame;
+	uint8_t done;
+	avr_cycle_count_t latched;
+} trial;
+
+static uint8_t scene;
+static uint8_t scene_started;
+
+static void mark (uint8_t id, avr_cycle_count_t cycle) {
+	if (id >= BENCH_SCENE(0) && id < BENCH_SCENE(BENCH_SCENES)) {
+		scene = id - BENCH_SCENE(0);
+		scene_started = 1;
+	}
+
+	if (!trial.armed)
+		return;
+	if (id == BENCH_EVENT(trial.event))
+		trial.seen_event = 1;
+	else if (id == BENCH_FRAME && trial.seen_event)
+		trial.seen_frame = 1;
+}
+
+static void xlat (uint8_t level, avr_cycle_count_t cycle) {
+	if (!level || !trial.armed || trial.done)
+		return;
+	if (trial.seen_event && (trial.seen_frame || !trial.drawn)) {
+		trial.latched = cycle;
+		trial.done = 1;
+	}
+}
+
+static void arm (uint8_t event, uint8_t drawn) {
+	memset(&trial, 0, sizeof(trial));
+	trial.event = event;
+	trial.drawn = drawn;
+	trial.armed = 1;
+}
+
+static int run_ms (uint32_t ms) {
+	return avrsim_run(avrsim_now() + avrsim_ms(ms), NULL) < 0 ? -1 : 0;
+}
+
+// Wait for the armed trial from the edge at t0, and keep the result
+static int measure (uint8_t in, avr_cycle_count_t t0) {
+	int n;
+
+	if (!trial.done && avrsim_run(t0 + avrsim_ms(TIMEOUT_MS), &trial.done) < 0)
+		return -1;
+	trial.armed = 0;
+
+	if (!trial.done) {
+		fprintf(stderr, "scene %u %s: nothing after %ums\n", scene, input_names[in], TIMEOUT_MS);
+		return -1;
+	}
+
+	n = num_samples[num_scenes-1][in]++;
+	samples[num_scenes-1][in][n] = trial.latched - t0;
+	return 0;
+}
+
+// Move the slide switch.  The pins are break before make.
+static void set_switch (uint8_t pin) {
+	avrsim_input(SWITCH_OFF_PIN, 0);
+	avrsim_input(SWITCH_SENSE_PIN, 0);
+	avrsim_input(SWITCH_ON_PIN, 0);
+	avrsim_input(pin, 1);
+}
+
+static int press (uint32_t ms) {
+	avrsim_input(BUTTON_PIN, 1);
+	if (run_ms(ms))
+		return -1;
+	avrsim_input(BUTTON_PIN, 0);
+	return 0;
+}
+
+static int do_input (uint8_t in) {
+	avr_cycle_count_t t0;
+
+	if (run_ms(WAIT_MIN_MS + rand() % (WAIT_MAX_MS - WAIT_MIN_MS)))
+		return -1;
+
+	switch (in) {
+	case IN_SHORT :
+		if (press(CLICK_MS))
+			return -1;
+		arm(EV_BUTTON, 0);
+		t0 = avrsim_now();
+		break;
+	case IN_DOUBLE :
+		if (press(CLICK_MS) || run_ms(DOUBLE_GAP_MS))
+			return -1;
+		arm(EV_BUTTON, 0);
+		t0 = avrsim_now();
+		if (press(CLICK_MS))
+			return -1;
+		break;
+	case IN_LONG :
+		arm(EV_BUTTON, 0);
+		t0 = avrsim_now();
+		if (press(LONG_MS))
+			return -1;
+		break;
+	case IN_OFF :
+		arm(EV_SWITCH, 0);
+		t0 = avrsim_now();
+		set_switch(SWITCH_OFF_PIN);
+		break;
+	case IN_ON :
+		arm(EV_SWITCH, 1);
+		t0 = avrsim_now();
+		set_switch(SWITCH_ON_PIN);
+		break;
+	case IN_SENSE :
+		arm(EV_SWITCH, 0);
+		t0 = avrsim_now();
+		set_switch(SWITCH_SENSE_PIN);
+		break;
+	default :
+		arm(EV_SWITCH, 1);
+		t0 = avrsim_now();
+		set_switch(SWITCH_ON_PIN);
+		break;
+	}
+
+	return measure(in, t0);
+}
+
+static int cmp_cycles (const void *a, const void *b) {
+	avr_cycle_count_t x = *(const avr_cycle_count_t *) a, y = *(const avr_cycle_count_t *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+// Nearest rank percentile of sorted samples, in ms
+static double percentile (const avr_cycle_count_t *s, int n, int pct) {
+	int rank = (pct * n + 99) / 100;
+
+	return avrsim_us(s[rank > 0 ? rank - 1 : 0]) / 1000;
+}
+
+static void print_stats (FILE *f, const char *name, avr_cycle_count_t *s, int n, const char *after) {
+	double sum = 0;
+
+	qsort(s, n, sizeof(*s), cmp_cycles);
+	for (int i = 0; i < n; i++)
+		sum += avrsim_us(s[i]) / 1000;
+
+	fprintf(f, "\"%s\": {\"trials\": %d, \"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, "
+		"\"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"spread\": %.3f}%s",
+		name, n, avrsim_us(s[0]) / 1000, sum / n, percentile(s, n, 50),
+		percentile(s, n, 90), percentile(s, n, 99), avrsim_us(s[n-1]) / 1000,
+		avrsim_us(s[n-1] - s[0]) / 1000, after);
+}
+
+static void report (FILE *f, const char *elf, uint32_t freq, unsigned seed) {
+	avr_cycle_count_t *all;
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"elf\": \"%s\",\n", elf);
+	fprintf(f, "  \"f_cpu\": %u,\n", freq);
+	fprintf(f, "  \"seed\": %u,\n", seed);
+	fprintf(f, "  \"units\": \"ms\",\n");
+
+	fprintf(f, "  \"all\": {\n");
+	all = malloc(sizeof(*all) * trials * num_scenes);
+	for (int in = 0; in < NUM_INPUTS; in++) {
+		int n = 0;
+
+		for (int s = 0; s < num_scenes; s++) {
+			memcpy(&all[n], samples[s][in], sizeof(*all) * num_samples[s][in]);
+			n += num_samples[s][in];
+		}
+		fprintf(f, "    ");
+		print_stats(f, input_names[in], all, n, in + 1 < NUM_INPUTS ? ",\n" : "\n");
+	}
+	free(all);
+	fprintf(f, "  },\n");
+
+	fprintf(f, "  \"scenes\": [\n");
+	for (int s = 0; s < num_scenes; s++) {
+		fprintf(f, "    {\n      \"scene\": %u,\n", scene_order[s]);
+		for (int in = 0; in < NUM_INPUTS; in++) {
+			fprintf(f, "      ");
+			print_stats(f, input_names[in], samples[s][in], num_samples[s][in],
+				in + 1 < NUM_INPUTS ? ",\n" : "\n");
+		}
+		fprintf(f, "    }%s\n", s + 1 < num_scenes ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+}
+
+static void usage (const char *name) {
+	fprintf(stderr, "usage: %s [-m mcu] [-f hz] [-n trials] [-r seed] [-o report.json] main.elf\n", name);
+	exit(EXIT_FAILURE);
+}
+
+int main (int argc, char **argv) {
+	const char *mcu = "atmega168";
+	const char *out = NULL;
+	uint32_t freq = 8000000;
+	unsigned seed = 1;
+	uint8_t first_scene;
+	FILE *f = stdout;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:f:n:r:o:")) != -1) {
+		switch (opt) {
+		case 'm' :
+			mcu = optarg;
+			break;
+		case 'f' :
+			freq = strtoul(optarg, NULL, 0);
+			break;
+		case 'n' :
+			trials = atoi(optarg);
+			break;
+		case 'r' :
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		case 'o' :
+			out = optarg;
+			break;
+		default :
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1 || trials < 1)
+		usage(argv[0]);
+	srand(seed);
+
+	if (avrsim_load(argv[optind], mcu, freq))
+		return EXIT_FAILURE;
+	avrsim_on_mark(mark);
+	avrsim_watch_pin(XLAT_PIN, xlat);
+
+	avrsim_input(BUTTON_PIN, 0);
+	set_switch(SWITCH_ON_PIN);
+
+	if (avrsim_run(avrsim_ms(1000), &scene_started) != 1) {
+		fprintf(stderr, "%s: no scene started, was it built with BENCH=1?\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+	first_scene = scene;
+
+	do {
+		scene_order[num_scenes++] = scene;
+		for (int in = 0; in < NUM_INPUTS; in++)
+			samples[num_scenes-1][in] = malloc(sizeof(avr_cycle_count_t) * trials);
+
+		// In order, so each input starts from where the one before left it:
+		// double comes back from the scene short went to, and switch_on and
+		// sense_to_on put the switch back on after switch_off and sense
+		for (int t = 0; t < trials; t++) {
+			for (int in = 0; in < NUM_INPUTS; in++) {
+				if (do_input(in))
+					return EXIT_FAILURE;
+			}
+		}
+		fprintf(stderr, "scene %u: %d trials of each input\n", scene, trials);
+
+		// On to the next scene
+		scene_started = 0;
+		if (run_ms(WAIT_MIN_MS) || press(CLICK_MS))
+			return EXIT_FAILURE;
+		if (avrsim_run(avrsim_now() + avrsim_ms(1000), &scene_started) != 1) {
+			fprintf(stderr, "the button didn't change the scene\n");
+			return EXIT_FAILURE;
+		}
+	} while (scene != first_scene && num_scenes < MAX_SCENES);
+
+	if (out && !(f = fopen(out, "w"))) {
+		perror(out);
+		return EXIT_FAILURE;
+	}
+	report(f, argv[optind], freq, seed);
+	if (f != stdout)
+		fclose(f);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sim_avr.h>
+#include <sim_elf.h>
+#include <sim_io.h>
+#include <sim_irq.h>
+#include <avr_ioport.h>
+
+#include "avrsim.h"
+
+// GPIOR0 in data space, where the bench.h markers go
+#define MARK_ADDR 0x3E
+
+static avr_t *avr;
+static avrsim_mark_t on_mark;
+static avrsim_pin_t on_pin;
+static uint32_t marks = 0;
+
+static void mark_written (struct avr_t *a, avr_io_addr_t addr, uint8_t v, void *param) {
+	a->data[addr] = v;
+	marks++;
+	if (on_mark)
+		on_mark(v, a->cycle);
+}
+
+int avrsim_load (const char *elf, const char *mcu, uint32_t freq) {
+	elf_firmware_t fw;
+
+	memset(&fw, 0, sizeof(fw));
+	if (elf_read_firmware(elf, &fw)) {
+		fprintf(stderr, "%s: can't read it\n", elf);
+		return -1;
+	}
+
+	// main.elf doesn't carry the .mmcu section, so it's up to us
+	if (!(avr = avr_make_mcu_by_name(mcu))) {
+		fprintf(stderr, "simavr doesn't know the %s\n", mcu);
+		return -1;
+	}
+	avr_init(avr);
+	avr_load_firmware(avr, &fw);
+	avr->frequency = freq;
+
+	avr_register_io_write(avr, MARK_ADDR, mark_written, NULL);
+	return 0;
+}
+
+void avrsim_on_mark (avrsim_mark_t mark) {
+	on_mark = mark;
+}
+
+void avrsim_input (uint8_t pin, uint8_t level) {
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), pin), level);
+}
+
+int avrsim_run (avr_cycle_count_t until, const uint8_t *stop) {
+	while (avr->cycle < until) {
+		int state = avr_run(avr);
+
+		if (state == cpu_Done || state == cpu_Crashed) {
+			fprintf(stderr, "firmware %s at cycle %llu\n",
+				state == cpu_Crashed ? "crashed" : "stopped",
+				(unsigned long long) avr->cycle);
+			return -1;
+		}
+		if (stop && *stop)
+			return 1;
+	}
+	return 0;
+}
+
+static void pin_changed (struct avr_irq_t *irq, uint32_t value, void *param) {
+	on_pin(value, avr->cycle);
+}
+
+void avrsim_watch_pin (uint8_t pin, avrsim_pin_t watch) {
+	on_pin = watch;
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), pin), pin_changed, NULL);
+}
+
+avr_cycle_count_t avrsim_now (void) {
+	return avr->cycle;
+}
+
+avr_cycle_count_t avrsim_ms (uint32_t ms) {
+	return (avr_cycle_count_t) avr->frequency * ms / 1000;
+}
+
+double avrsim_us (avr_cycle_count_t cycles) {
+	return cycles * 1e6 / avr->frequency;
+}
+
+uint32_t avrsim_marks (void) {
+	return marks;
+}
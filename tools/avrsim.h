@@ -0,0 +1,46 @@
+#ifndef AVRSIM_H
+#define AVRSIM_H
+
+#include <stdint.h>
+
+#include <sim_avr.h>
+
+/*
+   simavr harness for the simulator tools (tools/avrbench.c and
+   tools/avrlatency.c)
+
+   Loads main.elf into a simulated ATmega168 and gives a tool what it needs
+   from it: each bench.h marker with the cycle it was written at, the button
+   and slide switch pins to drive, an output pin to watch, and running up to
+   a given cycle.  There is one simulation per process.
+*/
+
+typedef void (*avrsim_mark_t)(uint8_t id, avr_cycle_count_t cycle);
+
+// Returns 0, or -1 after printing why it couldn't
+int avrsim_load(const char *elf, const char *mcu, uint32_t freq);
+
+// Have mark called for every write to the marker register
+void avrsim_on_mark(avrsim_mark_t mark);
+
+// Drive port D pin n, 0 - 7, from outside
+void avrsim_input(uint8_t pin, uint8_t level);
+
+// Have watch called with the cycle every time the firmware changes port D
+// pin n.  One pin at a time.
+typedef void (*avrsim_pin_t)(uint8_t level, avr_cycle_count_t cycle);
+void avrsim_watch_pin(uint8_t pin, avrsim_pin_t watch);
+
+// Run until the cycle count reaches until, or stop is set by one of the
+// callbacks.  Returns 1 if stopped, 0 at until, -1 if the firmware crashed
+// or stopped for good.
+int avrsim_run(avr_cycle_count_t until, const uint8_t *stop);
+
+avr_cycle_count_t avrsim_now(void);
+avr_cycle_count_t avrsim_ms(uint32_t ms);
+double avrsim_us(avr_cycle_count_t cycles);
+
+// Markers seen so far
+uint32_t avrsim_marks(void);
+
+#endif
@@ -0,0 +1,246 @@
+/*
+   sunc - sun show keyframe compiler
+
+   Reads the keyframe description (sun_bands.txt) and writes sun_table.h and
+   sun_table.c for the firmware.  Every fade from one keyframe to the next
+   becomes a start value and a per-frame step in the fixed point the sun show
+   engine adds up, with the green-avoiding hue direction already decided, so
+   the firmware does no float math for the sun show at all.
+
+   usage: sunc sun_bands.txt sun_table.h sun_table.c
+
+   Built and run on the host by the Makefile.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#define MAX_BANDS    16
+#define MAX_SEGMENTS 64
+#define MAX_LEDS     8
+
+#define HUE_SCALE 4294967296.0			// a full turn in 16.16 fixed point
+#define SV_SCALE  (4095.0 * 65536.0)	// 12 bit saturation/value in 16.16
+
+struct band {
+	int leds[MAX_LEDS];
+	int num_leds;
+	float hsv[MAX_SEGMENTS][3];
+	int num_keys;
+};
+
+static struct band bands[MAX_BANDS];
+static int num_bands = 0;
+static int frames = 0;
+
+static const char *input;
+static int line_no = 0;
+
+static void fail (const char *msg) {
+	fprintf(stderr, "%s:%d: %s\n", input, line_no, msg);
+	exit(EXIT_FAILURE);
+}
+
+static void parse (FILE *f) {
+	char line[256];
+	char *tok, *end;
+	struct band *b;
+	float h, s, v;
+
+	while (fgets(line, sizeof(line), f)) {
+		line_no++;
+		if ((tok = strchr(line, '#')))
+			*tok = 0;
+		if (!(tok = strtok(line, " \t\r\n")))
+			continue;
+
+		if (!strcmp(tok, "frames")) {
+			if (!(tok = strtok(NULL, " \t\r\n")))
+				fail("frames needs a count");
+			frames = strtol(tok, &end, 10);
+			if (*end || frames <= 0 || frames > 65535)
+				fail("frames must be 1 - 65535");
+		} else if (!strcmp(tok, "band")) {
+			if (num_bands == MAX_BANDS)
+				fail("too many bands");
+			b = &bands[num_bands++];
+			while ((tok = strtok(NULL, " \t\r\n"))) {
+				if (b->num_leds == MAX_LEDS)
+					fail("too many LEDs in band");
+				b->leds[b->num_leds] = strtol(tok, &end, 10);
+				if (*end || b->leds[b->num_leds] < 0 || b->leds[b->num_leds] > 7)
+					fail("LEDs are numbered 0 - 7");
+				b->num_leds++;
+			}
+			if (!b->num_leds)
+				fail("band needs at least one LED");
+		} else {
+			if (!num_bands)
+				fail("keyframe before the first band");
+			b = &bands[num_bands-1];
+			if (b->num_keys == MAX_SEGMENTS)
+				fail("too many keyframes");
+			if (sscanf(tok, "%f", &h) != 1)
+				fail("expected frames, band or a keyframe");
+			if (!(tok = strtok(NULL, " \t\r\n")) || sscanf(tok, "%f", &s) != 1 ||
+				!(tok = strtok(NULL, " \t\r\n")) || sscanf(tok, "%f", &v) != 1)
+				fail("keyframe needs hue, saturation and value");
+			if (h < 0 || h >= 360 || s < 0 || s > 1 || v < 0 || v > 1)
+				fail("hue is 0 - 360 degrees, saturation and value 0 - 1");
+			b->hsv[b->num_keys][0] = h/360.0;
+			b->hsv[b->num_keys][1] = s;
+			b->hsv[b->num_keys][2] = v;
+			b->num_keys++;
+		}
+	}
+
+	if (!frames)
+		fail("missing frames");
+	if (!num_bands)
+		fail("no bands");
+	for (int x = 0; x < num_bands; x++) {
+		if (bands[x].num_keys < 2)
+			fail("each band needs at least two keyframes");
+		if (bands[x].num_keys != bands[0].num_keys)
+			fail("every band needs the same number of keyframes");
+	}
+	if (frames % bands[0].num_keys)
+		fail("frames must divide evenly between the keyframes");
+}
+
+// How far the hue moves from h1 to h2, as a fraction of a turn
+static double hue_delta (float h1, float h2) {
+	// If we'd have to sweep through GREEN for H1 to get to H2, go the opposite
+	// way around the color wheel.  60/360 is where green starts (~ 0.1666...)
+	// and ends at about 180/360 (~ 0.5)
+	if ((h2 < h1) && (h2 < 0.16f) && (h1 > 0.5f))
+		return (h2+1.0)-h1;
+	// Likewise, if our sweep starts low, below the green belt and goes high
+	// to above green, take the other way around the color circle
+	if ((h1 < h2) && (h2 > 0.5f) && (h1 < 0.16f))
+		return h2-(h1+1.0);
+	return (double) h2-h1;
+}
+
+static void write_header (FILE *f, int segments, int max_leds) {
+	fprintf(f, "// Generated from %s by tools/sunc.  Edit that file, not this one.\n\n", input);
+	fprintf(f, "#ifndef SUN_TABLE_H\n#define SUN_TABLE_H\n\n");
+	fprintf(f, "#include <stdint.h>\n#include <avr/pgmspace.h>\n\n");
+	fprintf(f, "#define DAY_FRAMES    %d\n", frames);
+	fprintf(f, "#define DAY_SEGMENTS  %d\n", segments);
+	fprintf(f, "#define HOUR_INTERVAL %d\n", frames/segments);
+	fprintf(f, "#define SUN_BANDS     %d\n", num_bands);
+	fprintf(f, "#define SUN_BAND_LEDS %d\n", max_leds);
+	fprintf(f, "#define SUN_NO_LED    0xFF\n\n");
+	fprintf(f, "// One fade: where hue, saturation and value start and how much they move\n");
+	fprintf(f, "// per frame, with 16 fraction bits.  Hue wraps around at 32 bits.\n");
+	fprintf(f, "typedef struct {\n\tuint32_t start[3];\n\tint32_t  step[3];\n} sun_segment_t;\n\n");
+	fprintf(f, "extern const sun_segment_t sun_segments[SUN_BANDS][DAY_SEGMENTS] PROGMEM;\n\n");
+	fprintf(f, "// TLC5947 channel of each LED in a band, SUN_NO_LED pads short bands\n");
+	fprintf(f, "extern const uint8_t sun_rings[SUN_BANDS][SUN_BAND_LEDS] PROGMEM;\n\n");
+	fprintf(f, "#ifdef SUN_KEYFRAMES\n");
+	fprintf(f, "// The keyframes as written, hue as a fraction of a turn\n");
+	fprintf(f, "extern const float sun_keyframes[SUN_BANDS][DAY_SEGMENTS][3];\n");
+	fprintf(f, "#endif\n\n#endif\n");
+}
+
+static void write_source (FILE *f, const char *header, int segments, int max_leds) {
+	int interval = frames/segments;
+	int band, seg, next, x;
+	struct band *b;
+	float *k1, *k2;
+	double dh;
+
+	fprintf(f, "// Generated from %s by tools/sunc.  Edit that file, not this one.\n\n", input);
+	fprintf(f, "#include \"%s\"\n\n", header);
+
+	fprintf(f, "const sun_segment_t sun_segments[SUN_BANDS][DAY_SEGMENTS] PROGMEM = {\n");
+	for (band = 0; band < num_bands; band++) {
+		b = &bands[band];
+		fprintf(f, "\t{\n");
+		for (seg = 0; seg < segments; seg++) {
+			next = (seg+1)%segments;
+			k1 = b->hsv[seg];
+			k2 = b->hsv[next];
+			dh = hue_delta(k1[0], k2[0]);
+
+			fprintf(f, "\t\t{{0x%08lX, 0x%08lX, 0x%08lX}, {%ld, %ld, %ld}},\n",
+				(unsigned long) floor(k1[0] * HUE_SCALE),
+				(unsigned long) floor(k1[1] * SV_SCALE),
+				(unsigned long) floor(k1[2] * SV_SCALE),
+				lround(dh * HUE_SCALE / interval),
+				lround(((double) k2[1] - k1[1]) * SV_SCALE / interval),
+				lround(((double) k2[2] - k1[2]) * SV_SCALE / interval));
+		}
+		fprintf(f, "\t},\n");
+	}
+	fprintf(f, "};\n\n");
+
+	fprintf(f, "const uint8_t sun_rings[SUN_BANDS][SUN_BAND_LEDS] PROGMEM = {\n");
+	for (band = 0; band < num_bands; band++) {
+		fprintf(f, "\t{");
+		for (x = 0; x < max_leds; x++) {
+			if (x < bands[band].num_leds)
+				fprintf(f, "%s%d*3", x ? ", " : "", bands[band].leds[x]);
+			else
+				fprintf(f, ", SUN_NO_LED");
+		}
+		fprintf(f, "},\n");
+	}
+	fprintf(f, "};\n\n");
+
+	fprintf(f, "#ifdef SUN_KEYFRAMES\n");
+	fprintf(f, "const float sun_keyframes[SUN_BANDS][DAY_SEGMENTS][3] = {\n");
+	for (band = 0; band < num_bands; band++) {
+		fprintf(f, "\t{");
+		for (seg = 0; seg < segments; seg++) {
+			k1 = bands[band].hsv[seg];
+			fprintf(f, "%s{%.9g, %.9g, %.9g}", seg ? ", " : "", k1[0], k1[1], k1[2]);
+		}
+		fprintf(f, "},\n");
+	}
+	fprintf(f, "};\n#endif\n");
+}
+
+int main (int argc, char **argv) {
+	FILE *in, *h, *c;
+	const char *header;
+	int max_leds = 0;
+
+	if (argc != 4) {
+		fprintf(stderr, "usage: %s sun_bands.txt sun_table.h sun_table.c\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	input = argv[1];
+	if (!(in = fopen(input, "r"))) {
+		perror(input);
+		return EXIT_FAILURE;
+	}
+	parse(in);
+	fclose(in);
+
+	for (int x = 0; x < num_bands; x++)
+		if (bands[x].num_leds > max_leds)
+			max_leds = bands[x].num_leds;
+
+	// Include the header by name, it sits next to the source
+	header = strrchr(argv[2], '/') ? strrchr(argv[2], '/')+1 : argv[2];
+
+	if (!(h = fopen(argv[2], "w")) || !(c = fopen(argv[3], "w"))) {
+		perror("sunc");
+		return EXIT_FAILURE;
+	}
+	write_header(h, bands[0].num_keys, max_leds);
+	write_source(c, header, bands[0].num_keys, max_leds);
+
+	if (fclose(h) || fclose(c)) {
+		perror("sunc");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}